@@ -0,0 +1,196 @@
+#ifndef __BENCH_H_
+#define __BENCH_H_
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+minimal benchmark harness, header only and dependency free. a case is a
+function running iters calls of the operation under test, each doing
+ops_per_call operations. every case is warmed up, calibrated so a
+repetition lasts about min_time, then timed for reps repetitions; the
+per-operation times of the repetitions are reported as min, percentiles,
+mean and stddev on stderr and, with --json, as one JSON document for
+regression gating.
+
+  bench_options o = bench_parse(argc, argv, NULL);
+  bench_run(&o, "push/1000", push_fn, &arg, 1000);
+  bench_finish(&o);
+
+options: --filter <substring> --reps <n> --min-time <s> --warmup <s>
+         --json <path>
+*/
+
+#define BENCH_MAX_REPS 1000
+
+typedef void (*bench_fn)(void *arg, size_t iters);
+
+typedef struct bench_options {
+        const char *filter;
+        const char *json_path;
+        size_t reps;
+        double min_time;
+        double warmup;
+        FILE *json;
+        size_t n_results;
+} bench_options;
+
+typedef struct bench_result {
+        size_t iters;
+        double min;
+        double p50;
+        double p90;
+        double p99;
+        double max;
+        double mean;
+        double stddev;
+} bench_result;
+
+static inline double bench_clock(void) {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* keeps a result alive without the compiler proving it unused */
+static inline void bench_keep(double x) {
+        __asm__ __volatile__("" : : "g"(x) : "memory");
+}
+
+static inline int bench_compare(const void *a, const void *b) {
+        double x = *(const double *)a, y = *(const double *)b;
+        return (x > y) - (x < y);
+}
+
+/* nearest rank on sorted samples */
+static inline double bench_percentile(const double *sorted, size_t n,
+                                      double p) {
+        size_t rank = (size_t)ceil(p / 100.0 * n);
+        return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+/* context is extra JSON members describing the run, or NULL */
+static inline bench_options bench_parse(int argc, char **argv,
+                                        const char *context) {
+        bench_options o = {NULL, NULL, 15, 0.05, 0.1, NULL, 0};
+
+        for (int i = 1; i + 1 < argc; i += 2) {
+                if (strcmp(argv[i], "--filter") == 0)
+                        o.filter = argv[i + 1];
+                else if (strcmp(argv[i], "--json") == 0)
+                        o.json_path = argv[i + 1];
+                else if (strcmp(argv[i], "--reps") == 0)
+                        o.reps = strtoul(argv[i + 1], NULL, 10);
+                else if (strcmp(argv[i], "--min-time") == 0)
+                        o.min_time = strtod(argv[i + 1], NULL);
+                else if (strcmp(argv[i], "--warmup") == 0)
+                        o.warmup = strtod(argv[i + 1], NULL);
+                else
+                        fprintf(stderr, "[bench_parse] unknown option %s\n",
+                                argv[i]);
+        }
+        if (o.reps < 1)
+                o.reps = 1;
+        if (o.reps > BENCH_MAX_REPS)
+                o.reps = BENCH_MAX_REPS;
+        if (o.json_path) {
+                o.json = fopen(o.json_path, "w");
+                if (!o.json)
+                        fprintf(stderr, "[bench_parse] cannot open %s\n",
+                                o.json_path);
+        }
+        if (o.json) {
+                time_t now = time(NULL);
+                char date[32];
+                strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S",
+                         localtime(&now));
+                fprintf(o.json,
+                        "{\n  \"context\": {\"date\": \"%s\", \"reps\": %zu, "
+                        "\"min_time\": %g%s%s},\n  \"benchmarks\": [",
+                        date, o.reps, o.min_time, context ? ", " : "",
+                        context ? context : "");
+        }
+        fprintf(stderr, "%-28s %10s %10s %10s %10s %10s %12s\n", "benchmark",
+                "min ns/op", "p50", "p90", "p99", "max", "Mops/s");
+        return o;
+}
+
+static inline void bench_run(bench_options *o, const char *name, bench_fn fn,
+                             void *arg, size_t ops_per_call) {
+        double samples[BENCH_MAX_REPS];
+        bench_result r;
+        size_t iters = 1;
+
+        if (o->filter && !strstr(name, o->filter))
+                return;
+
+        /* warm caches, branch predictors and clocks */
+        double start = bench_clock();
+        do {
+                fn(arg, 1);
+        } while (bench_clock() - start < o->warmup);
+
+        /* grow iters until one repetition takes min_time */
+        for (;;) {
+                double t0 = bench_clock();
+                fn(arg, iters);
+                double elapsed = bench_clock() - t0;
+                if (elapsed >= o->min_time || iters >= ((size_t)1 << 40))
+                        break;
+                double scale = elapsed > 0 ? o->min_time / elapsed * 1.2 : 10;
+                iters = (size_t)(iters * (scale > 10 ? 10 : scale)) + 1;
+        }
+
+        double ops = (double)iters * ops_per_call;
+        for (size_t k = 0; k < o->reps; k++) {
+                double t0 = bench_clock();
+                fn(arg, iters);
+                samples[k] = (bench_clock() - t0) / ops * 1e9;
+        }
+        qsort(samples, o->reps, sizeof(double), bench_compare);
+        r.iters = iters;
+        r.min = samples[0];
+        r.max = samples[o->reps - 1];
+        r.p50 = bench_percentile(samples, o->reps, 50);
+        r.p90 = bench_percentile(samples, o->reps, 90);
+        r.p99 = bench_percentile(samples, o->reps, 99);
+        r.mean = 0.0;
+        for (size_t k = 0; k < o->reps; k++)
+                r.mean += samples[k];
+        r.mean /= o->reps;
+        r.stddev = 0.0;
+        for (size_t k = 0; k < o->reps; k++)
+                r.stddev += (samples[k] - r.mean) * (samples[k] - r.mean);
+        r.stddev = o->reps > 1 ? sqrt(r.stddev / (o->reps - 1)) : 0.0;
+
+        fprintf(stderr, "%-28s %10.3f %10.3f %10.3f %10.3f %10.3f %12.2f\n",
+                name, r.min, r.p50, r.p90, r.p99, r.max, 1e3 / r.p50);
+        if (o->json) {
+                fprintf(o->json,
+                        "%s\n    {\"name\": \"%s\", \"iterations\": %zu, "
+                        "\"ops_per_iteration\": %zu, \"repetitions\": %zu, "
+                        "\"ns_per_op\": {\"min\": %.4f, \"p50\": %.4f, "
+                        "\"p90\": %.4f, \"p99\": %.4f, \"max\": %.4f, "
+                        "\"mean\": %.4f, \"stddev\": %.4f}, "
+                        "\"ops_per_second\": %.1f}",
+                        o->n_results ? "," : "", name, r.iters, ops_per_call,
+                        o->reps, r.min, r.p50, r.p90, r.p99, r.max, r.mean,
+                        r.stddev, 1e9 / r.p50);
+        }
+        o->n_results++;
+}
+
+static inline void bench_finish(bench_options *o) {
+        if (o->json) {
+                fprintf(o->json, "\n  ]\n}\n");
+                fclose(o->json);
+                o->json = NULL;
+        }
+}
+
+#endif
@@ -0,0 +1,81 @@
+#include "bench.h"
+#include <pthread.h>
+#include "rs_vector.h"
+
+/*
+seqlock stress for rs_vector's concurrent-read mode: one writer pushes a
+series while 0, 1, 8 and 32 readers take snapshots in a loop. reports the
+writer's ns/update (against a plain vector as baseline), the readers'
+total snapshots and any torn snapshot, detected by checking that sum and
+mean agree with the count of a series of ones.
+
+usage: concurrent_snapshot [n_updates]
+*/
+
+typedef struct bench_reader {
+        rs_vector *v;
+        pthread_t thread;
+        size_t snapshots;
+        size_t torn;
+} bench_reader;
+
+static int bench_running;
+
+static void *bench_reader_main(void *arg) {
+        bench_reader *r = arg;
+        rs_stats s;
+
+        while (__atomic_load_n(&bench_running, __ATOMIC_ACQUIRE)) {
+                rs_vector_snapshot(r->v, &s);
+                if (s.sum != (double)s.count ||
+                    (s.count > 0 && s.mean != 1.0) || s.M2 != 0.0)
+                        r->torn++;
+                r->snapshots++;
+        }
+        return NULL;
+}
+
+static double bench_writer(size_t n, size_t n_readers, bool concurrent) {
+        rs_vector *v = rs_vector_alloc(n);
+        bench_reader *readers = calloc(n_readers, sizeof(bench_reader));
+        size_t snapshots = 0, torn = 0;
+
+        if (concurrent)
+                rs_vector_set_concurrent(v, true);
+        __atomic_store_n(&bench_running, 1, __ATOMIC_RELEASE);
+        for (size_t k = 0; k < n_readers; k++) {
+                readers[k].v = v;
+                pthread_create(&readers[k].thread, NULL, bench_reader_main,
+                               &readers[k]);
+        }
+        double t0 = bench_clock();
+        for (size_t i = 0; i < n; i++)
+                rs_vector_item_push(v, 1.0);
+        double elapsed = bench_clock() - t0;
+        __atomic_store_n(&bench_running, 0, __ATOMIC_RELEASE);
+        for (size_t k = 0; k < n_readers; k++) {
+                pthread_join(readers[k].thread, NULL);
+                snapshots += readers[k].snapshots;
+                torn += readers[k].torn;
+        }
+        fprintf(stderr, "%-10s readers %2zu  writer %7.2f ns/update",
+                concurrent ? "seqlock" : "plain", n_readers, elapsed / n * 1e9);
+        if (n_readers > 0)
+                fprintf(stderr, "  snapshots %12zu  torn %zu", snapshots,
+                        torn);
+        fprintf(stderr, "\n");
+        free(readers);
+        rs_vector_free(v);
+        return elapsed;
+}
+
+int main(int argc, char **argv) {
+        size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 20000000;
+        size_t reader_counts[] = {0, 1, 8, 32};
+
+        bench_writer(n, 0, false);
+        for (size_t k = 0; k < sizeof(reader_counts) / sizeof(reader_counts[0]);
+             k++)
+                bench_writer(n, reader_counts[k], true);
+        return 0;
+}
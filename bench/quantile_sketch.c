@@ -0,0 +1,164 @@
+#include "bench.h"
+#include "rs_vector.h"
+
+/*
+accuracy and cost of the KLL sketch behind rs_vector_set_sketch. for each
+k and input (uniform, normal, lognormal, sorted) reports the worst rank
+error over the 99 percentiles, for one sketch and for 8 shards merged,
+and the bytes kept against the 8 bytes per item of stored data. then times
+rs_vector_item_push with and without a sketch, storing and stats-only.
+
+usage: quantile_sketch [--filter s] [--reps n] [--min-time s]
+                       [--warmup s] [--json path]
+*/
+
+#define SKETCH_N 1000000
+#define SKETCH_SHARDS 8
+
+static uint64_t sketch_rng = 88172645463325252ull;
+
+static double sketch_uniform(void) {
+        sketch_rng ^= sketch_rng << 13;
+        sketch_rng ^= sketch_rng >> 7;
+        sketch_rng ^= sketch_rng << 17;
+        return (double)(sketch_rng >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static double sketch_normal(void) {
+        double x = -6.0;
+        for (int k = 0; k < 12; k++)
+                x += sketch_uniform();
+        return x;
+}
+
+static void sketch_fill(double *x, size_t n, int input) {
+        for (size_t i = 0; i < n; i++) {
+                switch (input) {
+                case 0:
+                        x[i] = sketch_uniform();
+                        break;
+                case 1:
+                        x[i] = sketch_normal();
+                        break;
+                case 2:
+                        x[i] = exp(sketch_normal());
+                        break;
+                default:
+                        x[i] = (double)i;
+                }
+        }
+}
+
+/* worst |true rank - q| over the percentiles, sorted holds the stream */
+static double sketch_error(rs_vector *v, const double *sorted, size_t n) {
+        double q[99], out[99], worst = 0.0;
+
+        for (int j = 0; j < 99; j++)
+                q[j] = (j + 1) / 100.0;
+        rs_vector_quantiles(v, q, 99, out);
+        for (int j = 0; j < 99; j++) {
+                size_t lo = 0, hi = n;
+                while (lo < hi) {
+                        size_t mid = lo + (hi - lo) / 2;
+                        if (sorted[mid] <= out[j])
+                                lo = mid + 1;
+                        else
+                                hi = mid;
+                }
+                double error = fabs((double)lo / (double)n - q[j]);
+                if (error > worst)
+                        worst = error;
+        }
+        return worst;
+}
+
+static rs_vector *sketch_vector(size_t k, bool stats_only) {
+        rs_vector_policy policy = rs_vector_policy_default;
+        policy.stats_only = stats_only;
+        rs_vector *v = rs_vector_alloc_policy(1, &policy);
+        if (k)
+                rs_vector_set_sketch(v, k);
+        return v;
+}
+
+static void sketch_accuracy(void) {
+        const char *inputs[] = {"uniform", "normal", "lognormal", "sorted"};
+        size_t ks[] = {50, 100, 200, 400};
+        double *x = malloc(SKETCH_N * sizeof(double));
+        double *sorted = malloc(SKETCH_N * sizeof(double));
+
+        fprintf(stderr, "%-10s %5s %12s %12s %10s\n", "input", "k",
+                "rank error", "merged 8", "bytes");
+        for (int input = 0; input < 4; input++) {
+                sketch_fill(x, SKETCH_N, input);
+                memcpy(sorted, x, SKETCH_N * sizeof(double));
+                qsort(sorted, SKETCH_N, sizeof(double), bench_compare);
+                for (size_t t = 0; t < 4; t++) {
+                        rs_vector *whole = sketch_vector(ks[t], true);
+                        rs_vector *merged = sketch_vector(ks[t], true);
+                        rs_vector *shards[SKETCH_SHARDS];
+
+                        for (int s = 0; s < SKETCH_SHARDS; s++)
+                                shards[s] = sketch_vector(ks[t], true);
+                        for (size_t i = 0; i < SKETCH_N; i++) {
+                                rs_vector_item_push(whole, x[i]);
+                                rs_vector_item_push(
+                                    shards[i % SKETCH_SHARDS], x[i]);
+                        }
+                        for (int s = 0; s < SKETCH_SHARDS; s++) {
+                                rs_vector_merge(merged, shards[s]);
+                                rs_vector_free(shards[s]);
+                        }
+                        fprintf(stderr, "%-10s %5zu %11.3f%% %11.3f%% %10zu\n",
+                                inputs[input], ks[t],
+                                100.0 * sketch_error(whole, sorted, SKETCH_N),
+                                100.0 * sketch_error(merged, sorted, SKETCH_N),
+                                rs_kll_bytes(whole->sketch));
+                        rs_vector_free(whole);
+                        rs_vector_free(merged);
+                }
+        }
+        fprintf(stderr, "stored data: %zu bytes\n\n",
+                (size_t)SKETCH_N * sizeof(double));
+        free(x);
+        free(sorted);
+}
+
+typedef struct sketch_push {
+        size_t k;
+        bool stats_only;
+        const double *x;
+} sketch_push;
+
+static void sketch_push_fn(void *arg, size_t iters) {
+        sketch_push *a = arg;
+
+        for (size_t it = 0; it < iters; it++) {
+                rs_vector *v = sketch_vector(a->k, a->stats_only);
+                for (size_t i = 0; i < SKETCH_N; i++)
+                        rs_vector_item_push(v, a->x[i]);
+                bench_keep(v->mean);
+                rs_vector_free(v);
+        }
+}
+
+int main(int argc, char **argv) {
+        double *x = malloc(SKETCH_N * sizeof(double));
+        char name[64];
+
+        sketch_accuracy();
+        bench_options o = bench_parse(argc, argv, NULL);
+        sketch_fill(x, SKETCH_N, 1);
+        size_t ks[] = {0, 100, 200, 400};
+        for (int stats_only = 0; stats_only < 2; stats_only++) {
+                for (size_t t = 0; t < 4; t++) {
+                        sketch_push a = {ks[t], stats_only, x};
+                        snprintf(name, sizeof(name), "push/%s/k%zu",
+                                 stats_only ? "stats_only" : "stored", ks[t]);
+                        bench_run(&o, name, sketch_push_fn, &a, SKETCH_N);
+                }
+        }
+        bench_finish(&o);
+        free(x);
+        return 0;
+}
@@ -0,0 +1,85 @@
+#include "bench.h"
+#include "rs_rolling.h"
+
+/*
+drift benchmark for rs_rolling: rolls a long series with a large offset and
+periodic level shifts, reports ns/step and the worst relative error of the
+sum, mean and variance series against an exact two-pass recomputation of a
+sample of windows, for the default path and for accuracy mode.
+
+usage: rolling_accuracy [n_samples] [window]
+*/
+
+static double bench_rel_err(double got, long double want) {
+        long double d = (long double)got - want;
+        if (d < 0)
+                d = -d;
+        if (want < 0)
+                want = -want;
+        return (double)(want > 0 ? d / want : d);
+}
+
+static void bench_mode(rs_vector *v, size_t window, const char *label,
+                       bool accurate, size_t reanchor_interval) {
+        unsigned int stats = RS_STAT_SUM | RS_STAT_MEAN | RS_STAT_VARIANCE;
+        rs_rolling *r = rs_rolling_alloc(v, window, stats);
+        rs_rolling_set_accuracy(r, accurate, reanchor_interval);
+
+        double t0 = bench_clock();
+        rs_rolling_roll(r, 0);
+        double elapsed = bench_clock() - t0;
+
+        double err_sum = 0.0, err_mean = 0.0, err_var = 0.0;
+        size_t negative = 0;
+        for (size_t j = 0; j < r->count; j++) {
+                if (r->variances->data[j] < 0.0)
+                        negative++;
+        }
+        for (size_t j = 0; j < r->count; j += 997) {
+                long double sum = 0.0L, m2 = 0.0L;
+                for (size_t i = j; i < j + window; i++)
+                        sum += v->data[i];
+                long double mean = sum / window;
+                for (size_t i = j; i < j + window; i++) {
+                        long double d = v->data[i] - mean;
+                        m2 += d * d;
+                }
+                double e;
+                e = bench_rel_err(r->sums->data[j], sum);
+                if (e > err_sum)
+                        err_sum = e;
+                e = bench_rel_err(r->means->data[j], mean);
+                if (e > err_mean)
+                        err_mean = e;
+                e = bench_rel_err(r->variances->data[j], m2 / (window - 1));
+                if (e > err_var)
+                        err_var = e;
+        }
+        fprintf(stdout, "%-22s %10.2f %12.3e %12.3e %12.3e %10zu\n", label,
+                elapsed * 1e9 / (r->count ? r->count : 1), err_sum, err_mean,
+                err_var, negative);
+        rs_rolling_free(r);
+}
+
+int main(int argc, char *argv[]) {
+        size_t n = argc > 1 ? strtoul(argv[1], NULL, 0) : 5000000;
+        size_t window = argc > 2 ? strtoul(argv[2], NULL, 0) : 1000;
+        rs_vector *v = rs_vector_alloc(n);
+
+        srand(42);
+        for (size_t i = 0; i < n; i++) {
+                double level = ((i / 100000) % 2) ? 1e9 : 1e3;
+                rs_vector_item_push(v, level + (double)rand() / RAND_MAX);
+        }
+
+        fprintf(stdout, "n=%zu window=%zu\n", n, window);
+        fprintf(stdout, "%-22s %10s %12s %12s %12s %10s\n", "mode", "ns/step",
+                "err sum", "err mean", "err var", "var < 0");
+        bench_mode(v, window, "default", false, 0);
+        bench_mode(v, window, "accurate K=window", true, window);
+        bench_mode(v, window, "accurate K=10*window", true, 10 * window);
+        bench_mode(v, window, "accurate K=window/10", true,
+                   window / 10 ? window / 10 : 1);
+        rs_vector_free(v);
+        return 0;
+}
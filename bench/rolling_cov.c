@@ -0,0 +1,118 @@
+#include "bench.h"
+#include "rs_rolling_cov.h"
+
+/*
+rolling pair statistics and covariance matrices. the pair engine (all four
+series) is timed against recomputing each window's co-moments from scratch,
+which is what rs_vector_dot per window amounts to; the covariance matrix is
+timed fed one row per call, so every row sweeps the matrix, and fed whole
+blocks of rows, so RS_COVMAT_BLOCK rows share one sweep.
+
+usage: rolling_cov [--filter s] [--reps n] [--min-time s] [--warmup s]
+                   [--json path]
+*/
+
+#define COV_N 1000000
+#define COV_ROWS 4096
+
+static double cov_value(size_t i) {
+        return (double)((i * 2654435761u) % 1000) / 1000.0;
+}
+
+typedef struct cov_pair {
+        rs_rolling_pair *p;
+} cov_pair;
+
+static void cov_pair_fn(void *arg, size_t iters) {
+        cov_pair *a = arg;
+
+        for (size_t it = 0; it < iters; it++)
+                rs_rolling_pair_roll(a->p, 0);
+        bench_keep(a->p->correlations->data[0]);
+}
+
+/* the per-window baseline, only the covariance, no allocations */
+static void cov_naive_fn(void *arg, size_t iters) {
+        cov_pair *a = arg;
+        const double *xs = a->p->x_data->data, *ys = a->p->y_data->data;
+        size_t window = a->p->window, size = COV_N - window + 1;
+        double *out = a->p->covariances->data;
+
+        for (size_t it = 0; it < iters; it++) {
+                for (size_t j = 0; j < size; j++) {
+                        double sx = 0.0, sy = 0.0, sxy = 0.0;
+                        for (size_t i = j; i < j + window; i++) {
+                                sx += xs[i];
+                                sy += ys[i];
+                                sxy += xs[i] * ys[i];
+                        }
+                        out[j] = (sxy - sx * sy / window) / (window - 1.0);
+                }
+        }
+        bench_keep(out[0]);
+}
+
+typedef struct cov_matrix {
+        rs_rolling_covmat *cm;
+        const double *rows;
+        bool blocked;
+} cov_matrix;
+
+static void cov_matrix_fn(void *arg, size_t iters) {
+        cov_matrix *a = arg;
+        size_t n = a->cm->n_series;
+
+        for (size_t it = 0; it < iters; it++) {
+                if (a->blocked) {
+                        rs_rolling_covmat_update_rows(a->cm, a->rows,
+                                                      COV_ROWS);
+                        continue;
+                }
+                for (size_t r = 0; r < COV_ROWS; r++)
+                        rs_rolling_covmat_update_row(a->cm, a->rows + r * n);
+        }
+        bench_keep(a->cm->C[1]);
+}
+
+int main(int argc, char **argv) {
+        bench_options o = bench_parse(argc, argv, NULL);
+        rs_vector *x = rs_vector_alloc(COV_N), *y = rs_vector_alloc(COV_N);
+        char name[64];
+
+        for (size_t i = 0; i < COV_N; i++) {
+                rs_vector_item_push(x, cov_value(i));
+                rs_vector_item_push(y, cov_value(i) * 0.5 + cov_value(i + 7));
+        }
+        size_t windows[] = {20, 250, 1000};
+        for (size_t w = 0; w < 3; w++) {
+                size_t size = COV_N - windows[w] + 1;
+                cov_pair a = {rs_rolling_pair_alloc(x, y, windows[w],
+                                                    RS_PAIR_ALL)};
+                snprintf(name, sizeof(name), "pair/w%zu", windows[w]);
+                bench_run(&o, name, cov_pair_fn, &a, size);
+                snprintf(name, sizeof(name), "pair/naive/w%zu", windows[w]);
+                bench_run(&o, name, cov_naive_fn, &a, size);
+                rs_rolling_pair_free(a.p);
+        }
+        rs_vector_free(x);
+        rs_vector_free(y);
+
+        size_t series[] = {16, 64, 256};
+        for (size_t s = 0; s < 3; s++) {
+                size_t n = series[s];
+                double *rows = malloc(COV_ROWS * n * sizeof(double));
+                for (size_t i = 0; i < COV_ROWS * n; i++)
+                        rows[i] = cov_value(i);
+                for (int blocked = 0; blocked < 2; blocked++) {
+                        cov_matrix a = {rs_rolling_covmat_alloc(n, 250), rows,
+                                        blocked};
+                        snprintf(name, sizeof(name), "covmat/%s/n%zu",
+                                 blocked ? "blocked" : "row", n);
+                        bench_run(&o, name, cov_matrix_fn, &a, COV_ROWS);
+                        rs_rolling_covmat_free(a.cm);
+                }
+                free(rows);
+        }
+        bench_finish(&o);
+        return 0;
+}
@@ -0,0 +1,66 @@
+#include "bench.h"
+#include <sys/stat.h>
+#include "rs_output.h"
+
+/*
+output throughput for rs_rolling: rolls every statistic over a random walk
+and times rs_rolling_print (stdout sent to /dev/null) against
+rs_rolling_write as csv, binary and mmap'd binary.
+
+usage: rolling_output [n_samples] [window] [path]
+*/
+
+static void bench_report(const char *label, size_t rows, double elapsed,
+                         const char *path) {
+        struct stat st;
+        double mb = 0.0;
+
+        if (path && stat(path, &st) == 0)
+                mb = st.st_size / 1e6;
+        fprintf(stderr, "%-12s %8.3f s %10.2f Mrows/s", label, elapsed,
+                rows / elapsed / 1e6);
+        if (path)
+                fprintf(stderr, " %9.1f MB %8.1f MB/s", mb, mb / elapsed);
+        fprintf(stderr, "\n");
+}
+
+int main(int argc, char **argv) {
+        size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 5000000;
+        size_t window = argc > 2 ? strtoul(argv[2], NULL, 10) : 100;
+        const char *path = argc > 3 ? argv[3] : "/tmp/rs_output_bench";
+        rs_vector *v = rs_vector_alloc(n);
+        double x = 0.0;
+
+        srand(7);
+        for (size_t i = 0; i < n; i++) {
+                x += rand() / (double)RAND_MAX - 0.5;
+                rs_vector_item_push(v, x);
+        }
+        rs_rolling *r = rs_rolling_alloc(v, window, RS_STAT_ALL);
+        rs_rolling_roll(r, 0);
+        fprintf(stderr, "rows %zu, columns 8\n", r->count);
+
+        double t0 = bench_clock();
+        if (!freopen("/dev/null", "w", stdout))
+                return 1;
+        rs_rolling_print(r);
+        fflush(stdout);
+        bench_report("print", r->count, bench_clock() - t0, NULL);
+
+        struct {
+                const char *label;
+                rs_output_format format;
+        } modes[] = {{"csv", RS_OUTPUT_CSV},
+                     {"binary", RS_OUTPUT_BINARY},
+                     {"mmap", RS_OUTPUT_MMAP}};
+        for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+                t0 = bench_clock();
+                if (rs_rolling_write(r, path, modes[m].format, 0) != 0)
+                        return 1;
+                bench_report(modes[m].label, r->count, bench_clock() - t0, path);
+        }
+        remove(path);
+        rs_rolling_free(r);
+        rs_vector_free(v);
+        return 0;
+}
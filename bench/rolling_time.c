@@ -0,0 +1,128 @@
+#include "bench.h"
+#include "rs_rolling_time.h"
+
+/*
+time-based rolling windows over irregular ticks. stamps advance by 0 to 19
+units with a quiet gap now and then and a burst of same-stamp ticks every
+TIME_BURST_EVERY samples, so the window count swings and the ring has to
+grow. each span is timed pushed one sample per call and as one bulk array,
+and with the ring reused across bursts against shrinking back after each
+one, which reallocates on every burst. before timing, windows starting at
+INT64_MIN are checked against a brute-force sum.
+
+usage: rolling_time [--filter s] [--reps n] [--min-time s] [--warmup s]
+                    [--json path]
+*/
+
+#define TIME_N 1000000
+#define TIME_BURST_EVERY 20000
+#define TIME_BURST 2000
+
+typedef struct time_case {
+        rs_rolling_time *t;
+        const int64_t *stamps;
+        const double *values;
+        rs_rolling_row *out;
+        bool batch;
+} time_case;
+
+static void time_fn(void *arg, size_t iters) {
+        time_case *a = arg;
+        rs_rolling_row row;
+
+        for (size_t it = 0; it < iters; it++) {
+                rs_rolling_time_reset(a->t);
+                if (a->batch) {
+                        rs_rolling_time_push_batch(a->t, a->stamps, a->values,
+                                                   TIME_N, a->out);
+                        continue;
+                }
+                for (size_t i = 0; i < TIME_N; i++) {
+                        rs_rolling_time_push(a->t, a->stamps[i], a->values[i]);
+                        rs_rolling_time_current(a->t, &row);
+                        bench_keep(row.mean);
+                }
+        }
+        bench_keep(a->out[TIME_N - 1].mean);
+}
+
+#define TIME_CHECK_N 200
+
+/* stamps from INT64_MIN, where now - span is not representable; the
+   unsigned difference of two ordered stamps is exact */
+static int time_check_low_stamps(void) {
+        int64_t stamps[TIME_CHECK_N], span = 5;
+        double values[TIME_CHECK_N];
+        rs_rolling_row out[TIME_CHECK_N];
+        rs_rolling_time *t = rs_rolling_time_alloc(span, RS_STAT_SUM, 4);
+        int rc = -1;
+
+        for (size_t i = 0; i < TIME_CHECK_N; i++) {
+                stamps[i] = INT64_MIN + (int64_t)(i / 2 + (i * 7) % 3);
+                if (i > 0 && stamps[i] < stamps[i - 1])
+                        stamps[i] = stamps[i - 1];
+                values[i] = (double)((i * 37) % 11);
+        }
+        if (t && rs_rolling_time_push_batch(t, stamps, values, TIME_CHECK_N,
+                                            out) == 0) {
+                rc = 0;
+                for (size_t i = 0; i < TIME_CHECK_N; i++) {
+                        double sum = 0.0;
+                        for (size_t j = 0; j <= i; j++) {
+                                if ((uint64_t)stamps[i] - (uint64_t)stamps[j] <
+                                    (uint64_t)span)
+                                        sum += values[j];
+                        }
+                        if (out[i].sum != sum) {
+                                fprintf(stderr,
+                                        "[rolling_time] row %zu sum %g, "
+                                        "expected %g\n",
+                                        i, out[i].sum, sum);
+                                rc = -1;
+                                break;
+                        }
+                }
+        }
+        rs_rolling_time_free(t);
+        return rc;
+}
+
+int main(int argc, char **argv) {
+        if (time_check_low_stamps() != 0)
+                return 1;
+        bench_options o = bench_parse(argc, argv, NULL);
+        int64_t *stamps = malloc(TIME_N * sizeof(int64_t));
+        double *values = malloc(TIME_N * sizeof(double));
+        rs_rolling_row *out = calloc(TIME_N, sizeof(rs_rolling_row));
+        int64_t stamp = 0;
+        char name[64];
+
+        for (size_t i = 0; i < TIME_N; i++) {
+                size_t h = i * 2654435761u;
+                if (i % TIME_BURST_EVERY >= TIME_BURST)
+                        stamp += h % 1000 < 5 ? 500 : (int64_t)(h % 20);
+                stamps[i] = stamp;
+                values[i] = (double)(h % 1000) / 1000.0;
+        }
+        int64_t spans[] = {100, 1000, 10000};
+        for (size_t s = 0; s < 3; s++) {
+                for (int mode = 0; mode < 3; mode++) {
+                        time_case a = {
+                            rs_rolling_time_alloc(spans[s], RS_STAT_ALL, 0),
+                            stamps, values, out, mode != 1};
+                        rs_rolling_time_set_reuse(a.t, mode != 2);
+                        snprintf(name, sizeof(name), "time/%s/span%lld",
+                                 mode == 0   ? "batch"
+                                 : mode == 1 ? "push"
+                                             : "batch-shrink",
+                                 (long long)spans[s]);
+                        bench_run(&o, name, time_fn, &a, TIME_N);
+                        rs_rolling_time_free(a.t);
+                }
+        }
+        free(stamps);
+        free(values);
+        free(out);
+        bench_finish(&o);
+        return 0;
+}
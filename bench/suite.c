@@ -0,0 +1,257 @@
+#include "bench.h"
+#include <unistd.h>
+#include "rs_instr.h"
+#include "rs_rolling.h"
+#include "rs_simd.h"
+
+/*
+hot path suite for make bench: push throughput, update ns/op, rolls (mean,
+all series, quantiles) over a grid of window sizes and series lengths,
+element-wise ops and resize growth. the context records whether the
+library was built with rs_instr counters (make bench INSTRUMENT=1) or
+timing (INSTRUMENT=timing), so the instrumentation overhead is the
+difference against a plain make bench; instrumented runs also time a
+counter snapshot and print the totals on stderr. before timing, skiplist
+insert, remove and quantiles and a rolling median are checked across +-inf.
+
+usage: suite [--filter s] [--reps n] [--min-time s] [--warmup s]
+             [--json path]
+*/
+
+typedef struct suite_push {
+        size_t n;
+} suite_push;
+
+/* fresh vector per call, so growth through rs_vector_expand is included */
+static void suite_push_fn(void *arg, size_t iters) {
+        suite_push *a = arg;
+
+        for (size_t it = 0; it < iters; it++) {
+                rs_vector *v = rs_vector_alloc(1);
+                for (size_t i = 0; i < a->n; i++)
+                        rs_vector_item_push(v, (double)(i & 1023));
+                bench_keep(v->mean);
+                rs_vector_free(v);
+        }
+}
+
+static void suite_update_fn(void *arg, size_t iters) {
+        rs_vector *v = arg;
+
+        for (size_t it = 0; it < iters; it++)
+                rs_vector_update(v, (double)(it & 1023));
+        bench_keep(v->M4);
+}
+
+typedef struct suite_roll {
+        rs_rolling *r;
+} suite_roll;
+
+static void suite_roll_fn(void *arg, size_t iters) {
+        suite_roll *a = arg;
+
+        for (size_t it = 0; it < iters; it++)
+                rs_rolling_roll(a->r, 0);
+        bench_keep(a->r->means->data[0]);
+}
+
+typedef struct suite_binary {
+        rs_vector *left;
+        rs_vector *right;
+        void (*op)(rs_vector *, rs_vector *);
+} suite_binary;
+
+static void suite_binary_fn(void *arg, size_t iters) {
+        suite_binary *a = arg;
+
+        for (size_t it = 0; it < iters; it++)
+                a->op(a->left, a->right);
+        bench_keep(a->left->mean);
+}
+
+typedef struct suite_resize {
+        size_t max_capacity;
+} suite_resize;
+
+/* doubles a vector from 2 slots to max_capacity, moving full contents */
+static void suite_resize_fn(void *arg, size_t iters) {
+        suite_resize *a = arg;
+
+        for (size_t it = 0; it < iters; it++) {
+                rs_vector *v = rs_vector_alloc(1);
+                while (v->capacity < a->max_capacity) {
+                        v->count = v->capacity - 1;
+                        rs_vector_resize(v, v->capacity * 2);
+                }
+                bench_keep(v->data[0]);
+                rs_vector_free(v);
+        }
+}
+
+static void suite_snapshot_fn(void *arg, size_t iters) {
+        rs_instr_counters c;
+
+        (void)arg;
+        for (size_t it = 0; it < iters; it++)
+                rs_instr_snapshot(&c);
+        bench_keep((double)c.pushes);
+}
+
+static rs_vector *suite_series(size_t n) {
+        rs_vector *v = rs_vector_alloc(n);
+        double x = 0.0;
+
+        srand(11);
+        for (size_t i = 0; i < n; i++) {
+                x += rand() / (double)RAND_MAX - 0.5;
+                rs_vector_item_push(v, x);
+        }
+        return v;
+}
+
+/* +inf and -inf sort, leave and interpolate like any other item; a walk
+   that relied on the sentinel's +inf value never ended on an +inf insert */
+static int suite_check_quantiles_inf(void) {
+        rs_skiplist *s = rs_skiplist_alloc(8);
+        double items[] = {1.0, INFINITY, -INFINITY, INFINITY, 2.0};
+        double series[10];
+        double medians[] = {1.0, 2.0, 3.0, 5.0, 6.0, 6.0, 7.0, 8.0};
+        double level = 0.5;
+        int rc = s ? 0 : -1;
+
+        for (size_t i = 0; rc == 0 && i < 5; i++)
+                rc = rs_skiplist_insert(s, items[i]);
+        if (rc == 0 &&
+            (rs_skiplist_get(s, 0) != -INFINITY ||
+             rs_skiplist_get(s, 4) != INFINITY ||
+             rs_skiplist_quantile(s, 0.5) != 2.0 ||
+             rs_skiplist_quantile(s, 0.9) != INFINITY ||
+             rs_skiplist_quantile(s, 0.0) != -INFINITY ||
+             rs_skiplist_remove(s, INFINITY) != 0 ||
+             rs_skiplist_remove(s, -INFINITY) != 0 ||
+             rs_skiplist_get(s, 0) != 1.0 ||
+             rs_skiplist_quantile(s, 1.0) != INFINITY ||
+             rs_skiplist_remove(s, INFINITY) != 0 ||
+             rs_skiplist_quantile(s, 1.0) != 2.0 || s->count != 2))
+                rc = -1;
+        rs_skiplist_free(s);
+        if (rc != 0) {
+                fprintf(stderr, "[suite] skiplist across +-inf failed\n");
+                return -1;
+        }
+
+        for (size_t i = 0; i < 10; i++)
+                series[i] = i == 4 ? INFINITY : (double)i;
+        rs_vector *v = rs_vector_alloc_calculate(series, 10);
+        rs_rolling *r = v ? rs_rolling_alloc(v, 3, RS_STAT_MEAN) : NULL;
+        rc = r && rs_rolling_set_quantiles(r, &level, 1) == 0 &&
+                     rs_rolling_roll(r, 0) == 0 && r->count == 8
+                 ? 0
+                 : -1;
+        for (size_t j = 0; rc == 0 && j < 8; j++) {
+                if (r->quantiles[0]->data[j] != medians[j]) {
+                        fprintf(stderr,
+                                "[suite] rolling median row %zu %g, "
+                                "expected %g\n",
+                                j, r->quantiles[0]->data[j], medians[j]);
+                        rc = -1;
+                }
+        }
+        rs_rolling_free(r);
+        rs_vector_free(v);
+        return rc;
+}
+
+int main(int argc, char **argv) {
+        char context[160];
+        char name[64];
+#ifdef RS_INSTRUMENT_TIMING
+        const char *instrument = "timing";
+#else
+        const char *instrument = rs_instr_enabled() ? "counters" : "off";
+#endif
+
+        snprintf(context, sizeof(context),
+                 "\"simd\": \"%s\", \"cpus\": %ld, "
+                 "\"instrument\": \"%s\"",
+                 rs_simd_level_name(rs_simd_get_level()),
+                 sysconf(_SC_NPROCESSORS_ONLN), instrument);
+        if (suite_check_quantiles_inf() != 0)
+                return 1;
+        bench_options o = bench_parse(argc, argv, context);
+
+        size_t push_sizes[] = {1000, 1000000};
+        for (size_t k = 0; k < 2; k++) {
+                suite_push a = {push_sizes[k]};
+                snprintf(name, sizeof(name), "push/%zu", push_sizes[k]);
+                bench_run(&o, name, suite_push_fn, &a, push_sizes[k]);
+        }
+
+        rs_vector *u = rs_vector_alloc(1);
+        bench_run(&o, "update", suite_update_fn, u, 1);
+        rs_vector_free(u);
+
+        size_t windows[] = {10, 100, 1000};
+        size_t lengths[] = {10000, 1000000};
+        for (size_t l = 0; l < 2; l++) {
+                rs_vector *v = suite_series(lengths[l]);
+                for (size_t w = 0; w < 3; w++) {
+                        /* quantiles: mean plus median, IQR, p95, p99 */
+                        unsigned int stats[] = {RS_STAT_MEAN, RS_STAT_ALL,
+                                                RS_STAT_MEAN};
+                        const char *labels[] = {"mean", "all", "quantiles"};
+                        double levels[] = {0.25, 0.5, 0.75, 0.95, 0.99};
+                        for (size_t s = 0; s < 3; s++) {
+                                suite_roll a = {rs_rolling_alloc(
+                                    v, windows[w], stats[s])};
+                                if (s == 2)
+                                        rs_rolling_set_quantiles(a.r, levels,
+                                                                 5);
+                                snprintf(name, sizeof(name),
+                                         "roll/%s/w%zu/n%zu", labels[s],
+                                         windows[w], lengths[l]);
+                                bench_run(&o, name, suite_roll_fn, &a,
+                                          lengths[l] - windows[w] + 1);
+                                rs_rolling_free(a.r);
+                        }
+                }
+                rs_vector_free(v);
+        }
+
+        /* ops that keep values bounded when repeated in place */
+        struct {
+                const char *name;
+                void (*op)(rs_vector *, rs_vector *);
+                double right;
+        } binary[] = {{"elementwise/add", rs_vector_add, 1.0},
+                      {"elementwise/sub", rs_vector_sub, 1.0},
+                      {"elementwise/mul", rs_vector_mul, 1.0000001},
+                      {"elementwise/div", rs_vector_div, 1.0000001}};
+        size_t n_elem = 1000000;
+        for (size_t k = 0; k < 4; k++) {
+                suite_binary a = {suite_series(n_elem), rs_vector_alloc(n_elem),
+                                  binary[k].op};
+                for (size_t i = 0; i < n_elem; i++)
+                        rs_vector_item_push(a.right, binary[k].right);
+                bench_run(&o, binary[k].name, suite_binary_fn, &a, n_elem);
+                rs_vector_free(a.left);
+                rs_vector_free(a.right);
+        }
+
+        size_t capacities[] = {1 << 10, 1 << 20};
+        for (size_t k = 0; k < 2; k++) {
+                suite_resize a = {capacities[k]};
+                size_t n_resizes = 0;
+                for (size_t c = 2; c < capacities[k]; c *= 2)
+                        n_resizes++;
+                snprintf(name, sizeof(name), "resize/%zu", capacities[k]);
+                bench_run(&o, name, suite_resize_fn, &a, n_resizes);
+        }
+
+        if (rs_instr_enabled()) {
+                bench_run(&o, "instr/snapshot", suite_snapshot_fn, NULL, 1);
+                rs_instr_dump_json(stderr);
+        }
+        bench_finish(&o);
+        return 0;
+}
@@ -1,6 +1,7 @@
 #include "circular_array.h"
+#include "rs_simd.h"
 
-circular_array *circular_array_alloc(size_t size) {
+circular_array *circular_array_alloc(size_t size, bool track_extrema) {
         if (size < 1) {
                 fprintf(stderr, "[circular_array_alloc] size must be > 0\n");
                 exit(-1);
@@ -12,6 +13,39 @@ circular_array *circular_array_alloc(size_t size) {
         }
         ca->size = size;
         ca->data = malloc(sizeof(double) * ca->size);
+        ca->min_deque = NULL;
+        ca->max_deque = NULL;
+        if (track_extrema) {
+                ca->min_deque = monotonic_deque_alloc(size, true);
+                ca->max_deque = monotonic_deque_alloc(size, false);
+        }
+        if (!ca->data ||
+            (track_extrema && (!ca->min_deque || !ca->max_deque))) {
+                fprintf(stderr, "[circular_array_alloc] malloc error\n");
+                circular_array_free(ca);
+                return NULL;
+        }
+        circular_array_reset(ca);
+        return ca;
+}
+
+circular_array *circular_array_place(rs_arena *a, size_t size,
+                                     bool track_extrema) {
+        circular_array *ca = rs_arena_take(a, sizeof(circular_array));
+        double *data = rs_arena_take(a, sizeof(double) * size);
+        monotonic_deque *min_deque = NULL, *max_deque = NULL;
+
+        if (track_extrema) {
+                min_deque = monotonic_deque_place(a, size, true);
+                max_deque = monotonic_deque_place(a, size, false);
+        }
+        if (!ca || !data || (track_extrema && (!min_deque || !max_deque))) {
+                return NULL;
+        }
+        ca->size = size;
+        ca->data = data;
+        ca->min_deque = min_deque;
+        ca->max_deque = max_deque;
         circular_array_reset(ca);
         return ca;
 }
@@ -21,6 +55,8 @@ void circular_array_free(circular_array *ca) {
                 if (ca->data) {
                         free(ca->data);
                 }
+                monotonic_deque_free(ca->min_deque);
+                monotonic_deque_free(ca->max_deque);
                 free(ca);
                 ca = NULL;
         }
@@ -32,93 +68,130 @@ int circular_array_reset(circular_array *ca) {
         if (ca) {
                 ca->head = 0;
                 ca->tail = 0;
+                ca->count = 0;
+                ca->seq = 0;
+                rs_moments_reset(&ca->moments);
                 memset(ca->data, 0.0, ca->size * sizeof(double));
+                if (ca->min_deque) {
+                        monotonic_deque_reset(ca->min_deque);
+                        monotonic_deque_reset(ca->max_deque);
+                }
                 rc = 0;
         }
         return rc;
 }
 
+int circular_array_resize(circular_array *ca, size_t size) {
+        if (size < ca->count || size < 1) {
+                fprintf(stderr, "[circular_array_resize] size %zu below "
+                                "count %zu\n",
+                        size, ca->count);
+                return -1;
+        }
+        double *data = malloc(sizeof(double) * size);
+        if (!data) {
+                fprintf(stderr, "[circular_array_resize] malloc error\n");
+                return -1;
+        }
+        if (ca->min_deque && (monotonic_deque_resize(ca->min_deque, size) ||
+                              monotonic_deque_resize(ca->max_deque, size))) {
+                free(data);
+                return -1;
+        }
+        size_t first = ca->size - ca->tail;
+        if (first > ca->count)
+                first = ca->count;
+        memcpy(data, ca->data + ca->tail, first * sizeof(double));
+        memcpy(data + first, ca->data, (ca->count - first) * sizeof(double));
+        free(ca->data);
+        ca->data = data;
+        ca->size = size;
+        ca->tail = 0;
+        ca->head = ca->count == size ? 0 : ca->count;
+        return 0;
+}
+
+/* putting into a full array evicts the oldest item first */
 int circular_array_put(circular_array *ca, double item) {
         int rc = -1;
 
         if (ca) {
+                if (circular_array_is_full(ca)) {
+                        double evicted;
+                        circular_array_get(ca, &evicted);
+                }
                 ca->data[ca->head] = item;
                 ca->head = (ca->head + 1) % ca->size;
+                ca->count++;
                 circular_array_update_stats_put(ca, item);
-
-                if (ca->head == ca->tail) {
-                        ca->tail = (ca->tail + 1) % ca->size;
+                if (ca->min_deque) {
+                        monotonic_deque_push(ca->min_deque, item, ca->seq);
+                        monotonic_deque_push(ca->max_deque, item, ca->seq);
                 }
+                ca->seq++;
                 rc = 0;
         }
         return rc;
 }
 
+/* removes the oldest item */
 int circular_array_get(circular_array *ca, double *out_value) {
         int rc = -1;
 
         if (ca && ca->data && !circular_array_is_empty(ca)) {
+                size_t index = ca->seq - ca->count;
                 *out_value = ca->data[ca->tail];
+                ca->tail = (ca->tail + 1) % ca->size;
+                ca->count--;
                 circular_array_update_stats_pop(ca, *out_value);
+                if (ca->min_deque) {
+                        monotonic_deque_evict(ca->min_deque, index);
+                        monotonic_deque_evict(ca->max_deque, index);
+                }
                 rc = 0;
         }
         return rc;
 }
 
 bool circular_array_is_empty(circular_array *ca) {
-        return (ca->head == ca->tail);
+        return (ca->count == 0);
 }
 
 bool circular_array_is_full(circular_array *ca) {
-        return ((ca->head + 1) % ca->size) == ca->tail;
+        return (ca->count == ca->size);
 }
 
+/* expects ca->count to already include item; min/max live in the deques */
 void circular_array_update_stats_put(circular_array *ca, double item)
 {
-        ca->sum += item;
-        double delta = item - ca->mean;
-        double delta_n, delta_nsq, term1, n;
-
-        /* update min and max */
-        if (ca->size == 0) {
-                ca->min = item;
-                ca->max = item;
-        } else {
-                if (item < ca->min)
-                        ca->min = item;
-                if (item > ca->max)
-                        ca->max = item;
-        }
-
-        /* from GSL rstat and John D. Cook, MIT license
-            http://www.johndcook.com/blog/skewness_kurtosis/ */
-        n = (double)ca->size;
-        delta_n = delta / n;
-        delta_nsq = delta_n * delta_n;
-        term1 = delta * delta_n * (n - 1.0);
-        ca->mean += delta_n;
-        ca->M4 += term1 * delta_nsq * (n * n - 3.0 * n + 3.0) +
-                 6.0 * delta_nsq * ca->M2 - 4.0 * delta_n * ca->M3;
-        ca->M3 += term1 * delta_n * (n - 2.0) - 3.0 * delta_n * ca->M2;
-        ca->M2 += term1;
+        rs_moments_put(&ca->moments, item, (double)ca->count, 4, false);
 }
 
+/* expects ca->count to already exclude item */
 void circular_array_update_stats_pop(circular_array *ca, double item)
 {
-        ca->sum -= item;
-        double delta, delta_n, delta_nsq, term1;
-
-        double n1 = (double)ca->size;
-        double n = n1 - 1.0;
-        delta = item - ca->mean;
-        delta_n = delta / n;
-        delta_nsq = delta_n * delta_n;
-        term1 = delta * delta_n * n1;
-        ca->mean -= delta_n;
-        ca->M2 -= term1;
-        ca->M3 -= term1 * delta_n * (n1 - 2.0) - 3.0 * delta_n * ca->M2;
-        ca->M4 -= term1 * delta_nsq * (n1 * n1 - 3.0 * n1 + 3.0) +
-                 6.0 * delta_nsq * ca->M2 - 4.0 * delta_n * ca->M3;
+        rs_moments_pop(&ca->moments, item, (double)ca->count, 4, false);
+}
+
+/* recomputes the moments from the buffer contents, discarding the drift
+   accumulated by the put/pop updates */
+void circular_array_reanchor(circular_array *ca)
+{
+        rs_stats a, b;
+        size_t first = ca->size - ca->tail;
+
+        if (first > ca->count)
+                first = ca->count;
+        rs_simd_stats(ca->data + ca->tail, first, &a);
+        rs_simd_stats(ca->data, ca->count - first, &b);
+        rs_stats_combine(&a, &b);
+
+        rs_moments_reset(&ca->moments);
+        ca->moments.sum = a.sum;
+        ca->moments.mean = a.mean;
+        ca->moments.M2 = a.M2;
+        ca->moments.M3 = a.M3;
+        ca->moments.M4 = a.M4;
 }
 
 void circular_array_print(circular_array *ca)
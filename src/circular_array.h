@@ -6,6 +6,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include "monotonic_deque.h"
+#include "rs_moments.h"
 
 /*
 taken from https://embeddedartistry.com/blog/2017/4/6/circular-buffers-in-cc
@@ -16,44 +18,66 @@ typedef struct circular_array {
         size_t head;
         size_t tail;
         size_t size;
-        double min;
-        double max;
-        double sum;
-        double mean;
-        double M2;
-        double M3;
-        double M4;
+        size_t count;
+        size_t seq;
+        monotonic_deque *min_deque;
+        monotonic_deque *max_deque;
+        rs_moments moments;
 } circular_array;
 
-circular_array *circular_array_alloc(size_t size);
+/* min/max deques are only allocated when track_extrema is set, without
+   them circular_array_min/max return NAN */
+circular_array *circular_array_alloc(size_t size, bool track_extrema);
+/* carved from an arena, not to be passed to circular_array_free */
+circular_array *circular_array_place(rs_arena *a, size_t size,
+                                     bool track_extrema);
 void circular_array_free(circular_array *ca);
 int circular_array_reset(circular_array *ca);
+/* reallocates to size (>= count) keeping the contents, oldest item moved
+   to index 0. heap arrays only */
+int circular_array_resize(circular_array *ca, size_t size);
 int circular_array_put(circular_array *ca, double item);
 int circular_array_get(circular_array *ca, double *out_value);
 bool circular_array_is_empty(circular_array *ca);
 bool circular_array_is_full(circular_array *ca);
 void circular_array_update_stats_put(circular_array *ca, double item);
 void circular_array_update_stats_pop(circular_array *ca, double item);
+void circular_array_reanchor(circular_array *ca);
 void circular_array_print(circular_array *ca);
 
-inline double circular_array_min(circular_array *ca) { return ca->min; }
-inline double circular_array_max(circular_array *ca) { return ca->max; }
-inline double circular_array_sum(circular_array *ca) { return ca->sum; }
-inline double circular_array_mean(circular_array *ca) { return ca->mean; }
+/* NAN on an empty window, whose deques hold nothing to read, or when
+   extrema are not tracked */
+inline double circular_array_min(circular_array *ca) {
+        if (ca->count == 0 || !ca->min_deque)
+                return NAN;
+        return ca->min_deque->values[ca->min_deque->front];
+}
+inline double circular_array_max(circular_array *ca) {
+        if (ca->count == 0 || !ca->max_deque)
+                return NAN;
+        return ca->max_deque->values[ca->max_deque->front];
+}
+inline double circular_array_sum(circular_array *ca) {
+        return ca->moments.sum;
+}
+inline double circular_array_mean(circular_array *ca) {
+        return ca->moments.mean;
+}
 
 inline double circular_array_variance(circular_array *ca) {
-        return (ca->M2 / (ca->size - 1.0));
+        return (ca->moments.M2 / (ca->count - 1.0));
 }
 inline double circular_array_stddev(circular_array *ca) {
         return sqrt(circular_array_variance(ca));
 }
 inline double circular_array_skewness(circular_array *ca) {
-        double fac = pow(ca->size - 1.0, 1.5) / (ca->size + 0.0);
-        return ((fac * ca->M3) / pow(ca->M2, 1.5));
+        double fac = pow(ca->count - 1.0, 1.5) / (ca->count + 0.0);
+        return ((fac * ca->moments.M3) / pow(ca->moments.M2, 1.5));
 }
 inline double circular_array_kurtosis(circular_array *ca) {
-        double fac = ((ca->size - 1.0) / ca->size) * (ca->size - 1.0);
-        return ((fac * ca->M4) / (ca->M2 * ca->M2) - 3.0);
+        double fac = ((ca->count - 1.0) / ca->count) * (ca->count - 1.0);
+        return ((fac * ca->moments.M4) /
+                    (ca->moments.M2 * ca->moments.M2) - 3.0);
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,37 @@
+#include "rs_vector.h"
+#include "rs_rolling.h"
+
+int main(int argc, char *argv[]) {
+        if (argc > 1) {
+                size_t n_vars = strtoul(argv[1], NULL, 0);
+                // size_t window = strtoul(argv[2], NULL, 0);
+
+                rs_vector *a = rs_vector_alloc(1);
+                rs_vector *b = rs_vector_alloc(1);
+
+                for (size_t i = 0; i < n_vars; i++) {
+                        rs_vector_item_push(a, (double)i + 1);
+                        rs_vector_item_push(b, (double)n_vars - i);
+                }
+                rs_vector_print(a);
+                rs_vector_print(b);
+                rs_vector_add(a, b);
+                rs_vector_print(a);
+                rs_vector_sub(a, b);
+                rs_vector_print(a);
+                rs_vector_mul(a, b);
+                rs_vector_print(a);
+                rs_vector_div(a, b);
+                rs_vector_print(a);
+                double d = rs_vector_dot(a, b);
+                fprintf(stdout, "Dot product: %.2f\n", d);
+                // rs_vector_print(v);
+                /*rs_rolling *r = rs_rolling_alloc(v, window, RS_STAT_ALL);
+                rs_rolling_roll(r, 0);
+                rs_rolling_print(r);
+
+                rs_rolling_free(r);*/
+                rs_vector_free(a);
+                rs_vector_free(b);
+        }
+}
\ No newline at end of file
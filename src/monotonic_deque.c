@@ -0,0 +1,96 @@
+#include "monotonic_deque.h"
+
+monotonic_deque *monotonic_deque_alloc(size_t size, bool ascending) {
+        if (size < 1) {
+                fprintf(stderr, "[monotonic_deque_alloc] size must be > 0\n");
+                exit(-1);
+        }
+        monotonic_deque *dq = malloc(sizeof(monotonic_deque));
+        if (!dq) {
+                fprintf(stderr, "[monotonic_deque_alloc] malloc error\n");
+                return NULL;
+        }
+        dq->size = size;
+        dq->ascending = ascending;
+        dq->values = malloc(sizeof(double) * dq->size);
+        dq->indices = malloc(sizeof(size_t) * dq->size);
+        if (!dq->values || !dq->indices) {
+                fprintf(stderr, "[monotonic_deque_alloc] malloc error\n");
+                monotonic_deque_free(dq);
+                return NULL;
+        }
+        monotonic_deque_reset(dq);
+        return dq;
+}
+
+monotonic_deque *monotonic_deque_place(rs_arena *a, size_t size,
+                                       bool ascending) {
+        monotonic_deque *dq = rs_arena_take(a, sizeof(monotonic_deque));
+        double *values = rs_arena_take(a, sizeof(double) * size);
+        size_t *indices = rs_arena_take(a, sizeof(size_t) * size);
+
+        if (!dq || !values || !indices) {
+                return NULL;
+        }
+        dq->size = size;
+        dq->ascending = ascending;
+        dq->values = values;
+        dq->indices = indices;
+        monotonic_deque_reset(dq);
+        return dq;
+}
+
+void monotonic_deque_free(monotonic_deque *dq) {
+        if (dq) {
+                if (dq->values) {
+                        free(dq->values);
+                }
+                if (dq->indices) {
+                        free(dq->indices);
+                }
+                free(dq);
+                dq = NULL;
+        }
+}
+
+int monotonic_deque_reset(monotonic_deque *dq) {
+        int rc = -1;
+
+        if (dq) {
+                dq->front = 0;
+                dq->count = 0;
+                rc = 0;
+        }
+        return rc;
+}
+
+/* the items are moved to the start of the new buffers */
+int monotonic_deque_resize(monotonic_deque *dq, size_t size) {
+        if (size < dq->count || size < 1) {
+                fprintf(stderr, "[monotonic_deque_resize] size %zu below "
+                                "count %zu\n",
+                        size, dq->count);
+                return -1;
+        }
+        double *values = malloc(sizeof(double) * size);
+        size_t *indices = malloc(sizeof(size_t) * size);
+        if (!values || !indices) {
+                fprintf(stderr, "[monotonic_deque_resize] malloc error\n");
+                free(values);
+                free(indices);
+                return -1;
+        }
+        for (size_t i = 0, pos = dq->front; i < dq->count; i++) {
+                values[i] = dq->values[pos];
+                indices[i] = dq->indices[pos];
+                if (++pos == dq->size)
+                        pos = 0;
+        }
+        free(dq->values);
+        free(dq->indices);
+        dq->values = values;
+        dq->indices = indices;
+        dq->size = size;
+        dq->front = 0;
+        return 0;
+}
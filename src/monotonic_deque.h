@@ -0,0 +1,82 @@
+#ifndef __MONOTONIC_DEQUE_H_
+#define __MONOTONIC_DEQUE_H_
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "rs_alloc.h"
+
+/*
+monotonic (ascending/descending) deque of (value, index) pairs used to track
+the min/max of a sliding window in amortised O(1) per step. an ascending deque
+keeps the window minimum at the front, a descending deque the maximum. each
+item is pushed and popped at most once, so a put+evict pair costs O(1)
+amortised regardless of the window length.
+*/
+
+typedef struct monotonic_deque {
+        double *values;
+        size_t *indices;
+        size_t front;
+        size_t count;
+        size_t size;
+        bool ascending;
+} monotonic_deque;
+
+monotonic_deque *monotonic_deque_alloc(size_t size, bool ascending);
+/* carved from an arena, not to be passed to monotonic_deque_free */
+monotonic_deque *monotonic_deque_place(rs_arena *a, size_t size,
+                                       bool ascending);
+void monotonic_deque_free(monotonic_deque *dq);
+int monotonic_deque_reset(monotonic_deque *dq);
+/* reallocates to size (>= count), heap deques only */
+int monotonic_deque_resize(monotonic_deque *dq, size_t size);
+
+static inline bool monotonic_deque_is_empty(monotonic_deque *dq) {
+        return (dq->count == 0);
+}
+
+static inline double monotonic_deque_front(monotonic_deque *dq) {
+        return dq->values[dq->front];
+}
+
+/* drop every item at the back that can no longer be an extremum, then append */
+static inline void monotonic_deque_push(monotonic_deque *dq, double item,
+                                        size_t index) {
+        while (dq->count > 0) {
+                size_t back = dq->front + dq->count - 1;
+                if (back >= dq->size)
+                        back -= dq->size;
+                if (dq->ascending ? dq->values[back] < item
+                                  : dq->values[back] > item)
+                        break;
+                dq->count--;
+        }
+        size_t pos = dq->front + dq->count;
+        if (pos >= dq->size)
+                pos -= dq->size;
+        dq->values[pos] = item;
+        dq->indices[pos] = index;
+        dq->count++;
+}
+
+/* item with sequence number index has left the window */
+static inline void monotonic_deque_evict(monotonic_deque *dq, size_t index) {
+        if (dq->count > 0 && dq->indices[dq->front] == index) {
+                if (++dq->front == dq->size)
+                        dq->front = 0;
+                dq->count--;
+        }
+}
+
+/* every item with a sequence number below index has left the window */
+static inline void monotonic_deque_evict_before(monotonic_deque *dq,
+                                                size_t index) {
+        while (dq->count > 0 && dq->indices[dq->front] < index) {
+                if (++dq->front == dq->size)
+                        dq->front = 0;
+                dq->count--;
+        }
+}
+
+#endif
@@ -0,0 +1,111 @@
+#define _DEFAULT_SOURCE
+#include "rs_alloc.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+static void *rs_alloc_malloc(void *ctx, size_t size) {
+        (void)ctx;
+        return malloc(size);
+}
+
+static void *rs_alloc_realloc(void *ctx, void *ptr, size_t old_size,
+                              size_t new_size) {
+        (void)ctx;
+        (void)old_size;
+        return realloc(ptr, new_size);
+}
+
+static void rs_alloc_free(void *ctx, void *ptr, size_t size) {
+        (void)ctx;
+        (void)size;
+        free(ptr);
+}
+
+const rs_allocator rs_allocator_default = {rs_alloc_malloc, rs_alloc_realloc,
+                                           rs_alloc_free, NULL};
+
+static void *rs_alloc_aligned(void *ctx, size_t size) {
+        void *ptr = NULL;
+        (void)ctx;
+        if (posix_memalign(&ptr, RS_ALLOC_ALIGNMENT, size) != 0)
+                return NULL;
+        return ptr;
+}
+
+/* realloc does not keep the alignment, so move by hand */
+static void *rs_alloc_aligned_resize(void *ctx, void *ptr, size_t old_size,
+                                     size_t new_size) {
+        void *moved = rs_alloc_aligned(ctx, new_size);
+        if (!moved)
+                return NULL;
+        if (ptr) {
+                memcpy(moved, ptr, old_size < new_size ? old_size : new_size);
+                free(ptr);
+        }
+        return moved;
+}
+
+const rs_allocator rs_allocator_aligned = {
+    rs_alloc_aligned, rs_alloc_aligned_resize, rs_alloc_free, NULL};
+
+static size_t rs_alloc_huge_size(size_t size) {
+        return (size + RS_ALLOC_HUGE_PAGE - 1) & ~(size_t)(RS_ALLOC_HUGE_PAGE - 1);
+}
+
+static void *rs_alloc_huge(void *ctx, size_t size) {
+        (void)ctx;
+        void *ptr = mmap(NULL, rs_alloc_huge_size(size), PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (ptr == MAP_FAILED)
+                return NULL;
+#ifdef MADV_HUGEPAGE
+        madvise(ptr, rs_alloc_huge_size(size), MADV_HUGEPAGE);
+#endif
+        return ptr;
+}
+
+static void rs_alloc_huge_release(void *ctx, void *ptr, size_t size) {
+        (void)ctx;
+        if (ptr)
+                munmap(ptr, rs_alloc_huge_size(size));
+}
+
+static void *rs_alloc_huge_resize(void *ctx, void *ptr, size_t old_size,
+                                  size_t new_size) {
+        /* both sizes round to the same mapping, nothing to do */
+        if (ptr && rs_alloc_huge_size(old_size) == rs_alloc_huge_size(new_size))
+                return ptr;
+        void *moved = rs_alloc_huge(ctx, new_size);
+        if (!moved)
+                return NULL;
+        if (ptr) {
+                memcpy(moved, ptr, old_size < new_size ? old_size : new_size);
+                rs_alloc_huge_release(ctx, ptr, old_size);
+        }
+        return moved;
+}
+
+const rs_allocator rs_allocator_huge = {
+    rs_alloc_huge, rs_alloc_huge_resize, rs_alloc_huge_release, NULL};
+
+static void *rs_alloc_none(void *ctx, size_t size) {
+        (void)ctx;
+        (void)size;
+        return NULL;
+}
+
+static void *rs_alloc_fixed_resize(void *ctx, void *ptr, size_t old_size,
+                                   size_t new_size) {
+        (void)ctx;
+        return new_size <= old_size ? ptr : NULL;
+}
+
+static void rs_alloc_fixed_release(void *ctx, void *ptr, size_t size) {
+        (void)ctx;
+        (void)ptr;
+        (void)size;
+}
+
+const rs_allocator rs_allocator_fixed = {
+    rs_alloc_none, rs_alloc_fixed_resize, rs_alloc_fixed_release, NULL};
@@ -0,0 +1,56 @@
+#ifndef __RS_ALLOC_H_
+#define __RS_ALLOC_H_
+
+#include <stddef.h>
+
+/*
+allocator callbacks for vector storage. sizes are in bytes and the size of
+the block is passed back on resize and release, so pools and arenas need no
+headers of their own. resize returns NULL and leaves the block untouched on
+failure, ctx is handed through unchanged.
+*/
+
+typedef struct rs_allocator {
+        void *(*alloc)(void *ctx, size_t size);
+        void *(*resize)(void *ctx, void *ptr, size_t old_size,
+                        size_t new_size);
+        void (*release)(void *ctx, void *ptr, size_t size);
+        void *ctx;
+} rs_allocator;
+
+/* malloc/realloc/free */
+extern const rs_allocator rs_allocator_default;
+/* posix_memalign to RS_ALLOC_ALIGNMENT, a full cache line / zmm register */
+extern const rs_allocator rs_allocator_aligned;
+/* anonymous mappings rounded to 2 MiB and advised MADV_HUGEPAGE */
+extern const rs_allocator rs_allocator_huge;
+
+/* storage owned elsewhere (an arena, a file mapping): never moves, only
+   shrinks in place, release is a no-op */
+extern const rs_allocator rs_allocator_fixed;
+
+#define RS_ALLOC_ALIGNMENT 64
+#define RS_ALLOC_HUGE_PAGE (2u << 20)
+
+/*
+bump allocator over one caller-owned block. every piece is aligned to
+RS_ALLOC_ALIGNMENT. with base NULL nothing is handed out and used only
+measures, so a layout function can be run once to size the block and once
+more to carve it.
+*/
+typedef struct rs_arena {
+        char *base;
+        size_t size;
+        size_t used;
+} rs_arena;
+
+static inline void *rs_arena_take(rs_arena *a, size_t bytes) {
+        size_t offset = (a->used + RS_ALLOC_ALIGNMENT - 1) &
+                        ~(size_t)(RS_ALLOC_ALIGNMENT - 1);
+        if (a->base && offset + bytes > a->size)
+                return NULL;
+        a->used = offset + bytes;
+        return a->base ? a->base + offset : NULL;
+}
+
+#endif
@@ -0,0 +1,328 @@
+#include "rs_d2s.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "rs_d2s_table.h"
+
+#define RS_D2S_MANTISSA_BITS 52
+#define RS_D2S_EXPONENT_BITS 11
+#define RS_D2S_BIAS 1023
+
+/* ceil(log2(5^e)), exact for 0 < e <= 3528 */
+static inline int32_t rs_d2s_pow5bits(int32_t e) {
+        return (int32_t)(((uint32_t)e * 1217359) >> 19) + 1;
+}
+
+/* floor(log10(2^e)) and floor(log10(5^e)) for 0 <= e <= 1650 */
+static inline uint32_t rs_d2s_log10_pow2(int32_t e) {
+        return ((uint32_t)e * 78913) >> 18;
+}
+
+static inline uint32_t rs_d2s_log10_pow5(int32_t e) {
+        return ((uint32_t)e * 732923) >> 20;
+}
+
+static inline uint32_t rs_d2s_pow5_factor(uint64_t value) {
+        uint32_t count = 0;
+        while (value % 5 == 0) {
+                value /= 5;
+                count++;
+        }
+        return count;
+}
+
+static inline bool rs_d2s_multiple_pow5(uint64_t value, uint32_t p) {
+        return rs_d2s_pow5_factor(value) >= p;
+}
+
+static inline bool rs_d2s_multiple_pow2(uint64_t value, uint32_t p) {
+        return (value & ((1ull << p) - 1)) == 0;
+}
+
+/* (m * mul) >> j with mul a 128 bit table entry and 64 < j < 128 */
+#if defined(__SIZEOF_INT128__)
+__extension__ typedef unsigned __int128 rs_d2s_u128;
+
+static inline uint64_t rs_d2s_mul_shift(uint64_t m, const uint64_t *mul,
+                                        int32_t j) {
+        rs_d2s_u128 b0 = (rs_d2s_u128)m * mul[0];
+        rs_d2s_u128 b2 = (rs_d2s_u128)m * mul[1];
+        return (uint64_t)(((b0 >> 64) + b2) >> (j - 64));
+}
+#else
+static inline uint64_t rs_d2s_umul128(uint64_t a, uint64_t b, uint64_t *hi) {
+        uint64_t a_lo = (uint32_t)a, a_hi = a >> 32;
+        uint64_t b_lo = (uint32_t)b, b_hi = b >> 32;
+        uint64_t b00 = a_lo * b_lo, b01 = a_lo * b_hi;
+        uint64_t b10 = a_hi * b_lo, b11 = a_hi * b_hi;
+        uint64_t mid1 = b10 + (b00 >> 32);
+        uint64_t mid2 = b01 + (uint32_t)mid1;
+        *hi = b11 + (mid1 >> 32) + (mid2 >> 32);
+        return (mid2 << 32) | (uint32_t)b00;
+}
+
+static inline uint64_t rs_d2s_mul_shift(uint64_t m, const uint64_t *mul,
+                                        int32_t j) {
+        uint64_t high1, high0;
+        uint64_t low1 = rs_d2s_umul128(m, mul[1], &high1);
+        rs_d2s_umul128(m, mul[0], &high0);
+        uint64_t sum = high0 + low1;
+        if (sum < high0)
+                high1++;
+        int32_t dist = j - 64;
+        if (dist == 64)
+                return high1;
+        return (high1 << (64 - dist)) | (sum >> dist);
+}
+#endif
+
+/* shortest digits of the double into *digits, returns their decimal exponent */
+static inline int32_t rs_d2s_decimal(uint64_t ieee_mantissa,
+                                     uint32_t ieee_exponent,
+                                     uint64_t *digits) {
+        int32_t e2;
+        uint64_t m2;
+
+        if (ieee_exponent == 0) {
+                e2 = 1 - RS_D2S_BIAS - RS_D2S_MANTISSA_BITS - 2;
+                m2 = ieee_mantissa;
+        } else {
+                e2 = (int32_t)ieee_exponent - RS_D2S_BIAS -
+                     RS_D2S_MANTISSA_BITS - 2;
+                m2 = (1ull << RS_D2S_MANTISSA_BITS) | ieee_mantissa;
+        }
+        const bool accept_bounds = (m2 & 1) == 0;
+
+        /* step 2: the interval of values that round to x, times 4 */
+        const uint64_t mv = 4 * m2;
+        const uint32_t mm_shift = ieee_mantissa != 0 || ieee_exponent <= 1;
+
+        /* step 3: convert to decimal, vr/vp/vm = mv/mp/mm * 10^-e10 */
+        uint64_t vr, vp, vm;
+        int32_t e10;
+        bool vm_trailing_zeros = false;
+        bool vr_trailing_zeros = false;
+
+        if (e2 >= 0) {
+                const uint32_t q = rs_d2s_log10_pow2(e2) - (e2 > 3);
+                const int32_t k = RS_D2S_POW5_INV_BITCOUNT +
+                                  rs_d2s_pow5bits((int32_t)q) - 1;
+                const int32_t i = -e2 + (int32_t)q + k;
+                const uint64_t *mul = RS_D2S_POW5_INV_SPLIT[q];
+
+                e10 = (int32_t)q;
+                vr = rs_d2s_mul_shift(4 * m2, mul, i);
+                vp = rs_d2s_mul_shift(4 * m2 + 2, mul, i);
+                vm = rs_d2s_mul_shift(4 * m2 - 1 - mm_shift, mul, i);
+                if (q <= 21) {
+                        /* only one of mp, mv and mm can be a multiple of 5 */
+                        if (mv % 5 == 0)
+                                vr_trailing_zeros =
+                                    rs_d2s_multiple_pow5(mv, q);
+                        else if (accept_bounds)
+                                vm_trailing_zeros = rs_d2s_multiple_pow5(
+                                    mv - 1 - mm_shift, q);
+                        else
+                                vp -= rs_d2s_multiple_pow5(mv + 2, q);
+                }
+        } else {
+                const uint32_t q = rs_d2s_log10_pow5(-e2) - (-e2 > 1);
+                const int32_t i = -e2 - (int32_t)q;
+                const int32_t k = rs_d2s_pow5bits(i) - RS_D2S_POW5_BITCOUNT;
+                const int32_t j = (int32_t)q - k;
+                const uint64_t *mul = RS_D2S_POW5_SPLIT[i];
+
+                e10 = (int32_t)q + e2;
+                vr = rs_d2s_mul_shift(4 * m2, mul, j);
+                vp = rs_d2s_mul_shift(4 * m2 + 2, mul, j);
+                vm = rs_d2s_mul_shift(4 * m2 - 1 - mm_shift, mul, j);
+                if (q <= 1) {
+                        /* mv has at least q trailing zero bits */
+                        vr_trailing_zeros = true;
+                        if (accept_bounds)
+                                vm_trailing_zeros = mm_shift == 1;
+                        else
+                                --vp;
+                } else if (q < 63) {
+                        vr_trailing_zeros = rs_d2s_multiple_pow2(mv, q);
+                }
+        }
+
+        /* step 4: drop digits while the interval still has a shorter member */
+        int32_t removed = 0;
+        uint8_t last_removed = 0;
+        uint64_t output;
+
+        if (vm_trailing_zeros || vr_trailing_zeros) {
+                while (vp / 10 > vm / 10) {
+                        vm_trailing_zeros &= vm % 10 == 0;
+                        vr_trailing_zeros &= last_removed == 0;
+                        last_removed = (uint8_t)(vr % 10);
+                        vr /= 10;
+                        vp /= 10;
+                        vm /= 10;
+                        removed++;
+                }
+                if (vm_trailing_zeros) {
+                        while (vm % 10 == 0) {
+                                vr_trailing_zeros &= last_removed == 0;
+                                last_removed = (uint8_t)(vr % 10);
+                                vr /= 10;
+                                vp /= 10;
+                                vm /= 10;
+                                removed++;
+                        }
+                }
+                /* exactly halfway, round to even */
+                if (vr_trailing_zeros && last_removed == 5 && vr % 2 == 0)
+                        last_removed = 4;
+                output = vr + ((vr == vm && (!accept_bounds ||
+                                             !vm_trailing_zeros)) ||
+                               last_removed >= 5);
+        } else {
+                /* common case, no trailing zeros to track */
+                bool round_up = false;
+                /* most values lose at least two digits, take them at once */
+                if (vp / 100 > vm / 100) {
+                        round_up = vr % 100 >= 50;
+                        vr /= 100;
+                        vp /= 100;
+                        vm /= 100;
+                        removed += 2;
+                }
+                while (vp / 10 > vm / 10) {
+                        round_up = vr % 10 >= 5;
+                        vr /= 10;
+                        vp /= 10;
+                        vm /= 10;
+                        removed++;
+                }
+                output = vr + (vr == vm || round_up);
+        }
+        *digits = output;
+        return e10 + removed;
+}
+
+/* digits outputs have at most 17 */
+static inline uint32_t rs_d2s_length(uint64_t v) {
+        static const uint64_t pow10[17] = {
+            10ull,          100ull,          1000ull,          10000ull,
+            100000ull,      1000000ull,      10000000ull,      100000000ull,
+            1000000000ull,  10000000000ull,  100000000000ull,  1000000000000ull,
+            10000000000000ull, 100000000000000ull, 1000000000000000ull,
+            10000000000000000ull, 100000000000000000ull};
+        uint32_t length = 17;
+        /* shortest outputs of random data are mostly 15-17 digits long */
+        while (length > 1 && v < pow10[length - 2])
+                length--;
+        return length;
+}
+
+static const char rs_d2s_digit_pairs[200] =
+    "000102030405060708091011121314151617181920212223242526272829303132333435"
+    "363738394041424344454647484950515253545556575859606162636465666768697071"
+    "72737475767778798081828384858687888990919293949596979899";
+
+/* writes the length digits of v ending just before end */
+static inline void rs_d2s_digits(uint64_t v, char *end) {
+        while (v >= 100) {
+                uint32_t c = (uint32_t)(v % 100) * 2;
+                v /= 100;
+                end -= 2;
+                memcpy(end, rs_d2s_digit_pairs + c, 2);
+        }
+        if (v >= 10) {
+                end -= 2;
+                memcpy(end, rs_d2s_digit_pairs + v * 2, 2);
+        } else {
+                *--end = (char)('0' + v);
+        }
+}
+
+size_t rs_d2s(double x, char *out) {
+        uint64_t bits;
+        memcpy(&bits, &x, sizeof(bits));
+
+        const bool sign =
+            ((bits >> (RS_D2S_MANTISSA_BITS + RS_D2S_EXPONENT_BITS)) & 1) != 0;
+        const uint64_t ieee_mantissa =
+            bits & ((1ull << RS_D2S_MANTISSA_BITS) - 1);
+        const uint32_t ieee_exponent =
+            (uint32_t)((bits >> RS_D2S_MANTISSA_BITS) &
+                       ((1u << RS_D2S_EXPONENT_BITS) - 1));
+        char *p = out;
+
+        if (ieee_exponent == (1u << RS_D2S_EXPONENT_BITS) - 1) {
+                if (ieee_mantissa) {
+                        memcpy(p, "nan", 3);
+                        return 3;
+                }
+                if (sign)
+                        *p++ = '-';
+                memcpy(p, "inf", 3);
+                return (size_t)(p - out) + 3;
+        }
+        if (sign)
+                *p++ = '-';
+        if (ieee_exponent == 0 && ieee_mantissa == 0) {
+                *p++ = '0';
+                return (size_t)(p - out);
+        }
+
+        uint64_t digits;
+        int32_t e10 = rs_d2s_decimal(ieee_mantissa, ieee_exponent, &digits);
+        int32_t length = (int32_t)rs_d2s_length(digits);
+        /* x = 0.d1d2...dn * 10^point */
+        int32_t point = length + e10;
+
+        if (point > 0 && point <= 17) {
+                if (point >= length) {
+                        rs_d2s_digits(digits, p + length);
+                        p += length;
+                        memset(p, '0', (size_t)(point - length));
+                        p += point - length;
+                } else {
+                        /* digits then shift the fraction right past a '.' */
+                        rs_d2s_digits(digits, p + length);
+                        memmove(p + point + 1, p + point,
+                                (size_t)(length - point));
+                        p[point] = '.';
+                        p += length + 1;
+                }
+        } else if (point <= 0 && point > -5) {
+                *p++ = '0';
+                *p++ = '.';
+                memset(p, '0', (size_t)-point);
+                p += -point;
+                rs_d2s_digits(digits, p + length);
+                p += length;
+        } else {
+                int32_t exp = point - 1;
+                if (length > 1) {
+                        /* d.ddd, write past the point then pull d1 down */
+                        rs_d2s_digits(digits, p + length + 1);
+                        p[0] = p[1];
+                        p[1] = '.';
+                        p += length + 1;
+                } else {
+                        *p++ = (char)('0' + digits);
+                }
+                *p++ = 'e';
+                if (exp < 0) {
+                        *p++ = '-';
+                        exp = -exp;
+                }
+                if (exp >= 100) {
+                        *p++ = (char)('0' + exp / 100);
+                        exp %= 100;
+                        memcpy(p, rs_d2s_digit_pairs + exp * 2, 2);
+                        p += 2;
+                } else if (exp >= 10) {
+                        memcpy(p, rs_d2s_digit_pairs + exp * 2, 2);
+                        p += 2;
+                } else {
+                        *p++ = (char)('0' + exp);
+                }
+        }
+        return (size_t)(p - out);
+}
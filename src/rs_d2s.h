@@ -0,0 +1,17 @@
+#ifndef __RS_D2S_H_
+#define __RS_D2S_H_
+
+#include <stddef.h>
+
+/* longest text rs_d2s produces, "-2.2250738585072014e-308" */
+#define RS_D2S_MAX_LENGTH 24
+
+/*
+shortest text that strtod reads back to exactly x, after Ulf Adams' Ryu
+(PLDI 2018). plain notation is used for decimal exponents in [-5, 17),
+scientific otherwise, specials are nan, inf and -inf. out needs
+RS_D2S_MAX_LENGTH bytes, it is not terminated and the length is returned.
+*/
+size_t rs_d2s(double x, char *out);
+
+#endif
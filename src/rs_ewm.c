@@ -0,0 +1,199 @@
+#include "rs_ewm.h"
+
+double rs_ewm_alpha_from_span(double span) { return 2.0 / (span + 1.0); }
+
+double rs_ewm_alpha_from_halflife(double halflife) {
+        return 1.0 - exp(-log(2.0) / halflife);
+}
+
+double rs_ewm_alpha_from_com(double com) { return 1.0 / (1.0 + com); }
+
+rs_ewm *rs_ewm_alloc(double alpha, bool adjust) {
+        rs_ewm *e = malloc(sizeof(rs_ewm));
+        if (!e) {
+                fprintf(stderr, "[rs_ewm_alloc] malloc error\n");
+                return NULL;
+        }
+        if (rs_ewm_init(e, alpha, adjust) != 0) {
+                free(e);
+                return NULL;
+        }
+        return e;
+}
+
+void rs_ewm_free(rs_ewm *e) {
+        if (e) {
+                free(e);
+                e = NULL;
+        }
+}
+
+int rs_ewm_init(rs_ewm *e, double alpha, bool adjust) {
+        if (!(alpha > 0.0 && alpha <= 1.0)) {
+                fprintf(stderr, "[rs_ewm_init] alpha must be in (0, 1]\n");
+                return -1;
+        }
+        e->alpha = alpha;
+        e->adjust = adjust;
+        rs_ewm_reset(e);
+        return 0;
+}
+
+void rs_ewm_reset(rs_ewm *e) {
+        e->count = 0;
+        e->mean = 0.0;
+        e->S = 0.0;
+        e->sum_w = 0.0;
+        e->sum_w2 = 0.0;
+}
+
+/* decay the old weights, then West's weighted update for the new item */
+void rs_ewm_update(rs_ewm *e, double item) {
+        double beta = 1.0 - e->alpha;
+        double w = (e->adjust || e->count == 0) ? 1.0 : e->alpha;
+
+        e->sum_w = beta * e->sum_w + w;
+        e->sum_w2 = beta * beta * e->sum_w2 + w * w;
+        double delta = item - e->mean;
+        e->mean += (w / e->sum_w) * delta;
+        e->S = beta * e->S + w * delta * (item - e->mean);
+        e->count++;
+}
+
+/*
+without adjust the total weight stays at 1 after the first sample, so four
+steps unroll into closed forms that each depend only on the state before the
+block: m_k = b^k m_0 + a sum b^(k-j) x_j and S_4 = b^4 S_0 + a b sum
+b^(4-k) d_k^2 with d_k = x_k - m_(k-1). the loop-carried chain is then one
+multiply-add per four samples for the mean and one for S.
+*/
+void rs_ewm_update_batch(rs_ewm *e, const double *items, size_t length) {
+        size_t i = 0;
+
+        if (e->adjust) {
+                for (; i < length; i++)
+                        rs_ewm_update(e, items[i]);
+                return;
+        }
+        if (e->count == 0 && length > 0) {
+                rs_ewm_update(e, items[i++]);
+        }
+        size_t first = i;
+
+        double a = e->alpha, b = 1.0 - a;
+        double b2 = b * b, b3 = b2 * b, b4 = b2 * b2;
+        double ab = a * b, ab2 = a * b2, ab3 = a * b3;
+        double w2_decay = b4 * b4;
+        double w2_add = a * a * (1.0 + b2 + b4 + b4 * b2);
+        double mean = e->mean, S = e->S, sum_w2 = e->sum_w2;
+
+        for (; i + 4 <= length; i += 4) {
+                double x1 = items[i], x2 = items[i + 1];
+                double x3 = items[i + 2], x4 = items[i + 3];
+                double m1 = b * mean + a * x1;
+                double m2 = b2 * mean + ab * x1 + a * x2;
+                double m3 = b3 * mean + ab2 * x1 + ab * x2 + a * x3;
+                double m4 = b4 * mean + ab3 * x1 + ab2 * x2 + ab * x3 +
+                            a * x4;
+                double d1 = x1 - mean, d2 = x2 - m1;
+                double d3 = x3 - m2, d4 = x4 - m3;
+                S = b4 * S + ab * (b3 * d1 * d1 + b2 * d2 * d2 +
+                                   b * d3 * d3 + d4 * d4);
+                sum_w2 = w2_decay * sum_w2 + w2_add;
+                mean = m4;
+        }
+        e->mean = mean;
+        e->S = S;
+        e->sum_w2 = sum_w2;
+        e->count += i - first;
+        for (; i < length; i++)
+                rs_ewm_update(e, items[i]);
+}
+
+rs_ewm_rolling *rs_ewm_rolling_alloc(rs_vector *v, double alpha, bool adjust,
+                                     unsigned int stats) {
+        stats &= RS_STAT_MEAN | RS_STAT_VARIANCE | RS_STAT_STDDEV;
+        if (!stats) {
+                fprintf(stderr,
+                        "[rs_ewm_rolling_alloc] no statistics selected\n");
+                return NULL;
+        }
+        if (!rs_vector_check_data("rs_ewm_rolling_alloc", v))
+                return NULL;
+        rs_ewm_rolling *r = malloc(sizeof(rs_ewm_rolling));
+        if (!r) {
+                fprintf(stderr, "[rs_ewm_rolling_alloc] malloc error\n");
+                return NULL;
+        }
+        r->count = 0;
+        r->stats = stats;
+        r->source_data = v;
+        if (rs_ewm_init(&r->ewm, alpha, adjust) != 0) {
+                free(r);
+                return NULL;
+        }
+        r->means = (stats & RS_STAT_MEAN) ? rs_vector_alloc(v->count) : NULL;
+        r->variances = (stats & RS_STAT_VARIANCE) ? rs_vector_alloc(v->count)
+                                                   : NULL;
+        r->stddevs = (stats & RS_STAT_STDDEV) ? rs_vector_alloc(v->count)
+                                               : NULL;
+        if (((stats & RS_STAT_MEAN) && !r->means) ||
+            ((stats & RS_STAT_VARIANCE) && !r->variances) ||
+            ((stats & RS_STAT_STDDEV) && !r->stddevs)) {
+                fprintf(stderr, "[rs_ewm_rolling_alloc] malloc error\n");
+                exit(1);
+        }
+        return r;
+}
+
+void rs_ewm_rolling_free(rs_ewm_rolling *r) {
+        if (r) {
+                if (r->means) rs_vector_free(r->means);
+                if (r->variances) rs_vector_free(r->variances);
+                if (r->stddevs) rs_vector_free(r->stddevs);
+                free(r);
+                r = NULL;
+        }
+}
+
+/* output slot j is the state after source sample start_index + j, written
+   in place as in rs_rolling_roll, -1 when the rows cannot be reserved */
+int rs_ewm_rolling_roll(rs_ewm_rolling *r, size_t start_index) {
+        int rc = -1;
+
+        if (r) {
+                size_t count = r->source_data->count;
+                size_t size = count > start_index ? count - start_index : 0;
+                const double *src = r->source_data->data + start_index;
+                rs_vector *series[] = {r->means, r->variances, r->stddevs};
+
+                for (size_t k = 0; k < 3; k++) {
+                        if (series[k] &&
+                            rs_vector_reserve(series[k], size) != 0) {
+                                fprintf(stderr, "[rs_ewm_rolling_roll] "
+                                                "realloc error\n");
+                                return -1;
+                        }
+                }
+                rs_ewm_reset(&r->ewm);
+                for (size_t j = 0; j < size; j++) {
+                        rs_ewm_update(&r->ewm, src[j]);
+                        if (r->means)
+                                r->means->data[j] = rs_ewm_mean(&r->ewm);
+                        if (r->variances || r->stddevs) {
+                                double variance = rs_ewm_variance(&r->ewm);
+                                if (r->variances)
+                                        r->variances->data[j] = variance;
+                                if (r->stddevs)
+                                        r->stddevs->data[j] = sqrt(variance);
+                        }
+                }
+                for (size_t k = 0; k < 3; k++) {
+                        if (series[k])
+                                series[k]->count = size;
+                }
+                r->count = size;
+                rc = 0;
+        }
+        return rc;
+}
@@ -0,0 +1,69 @@
+#ifndef __RS_EWM_H_
+#define __RS_EWM_H_
+
+#include "rs_rolling.h"
+
+/*
+exponentially weighted running mean/variance, O(1) memory per series and no
+window buffer. weights follow pandas' ewm: with adjust the observation k
+steps back has weight (1 - alpha)^k, without it the recursion
+mean = (1 - alpha) * mean + alpha * item is used from the first sample on.
+the variance is kept as West's weighted sum of squared deviations together
+with the sums of weights and squared weights, so both the biased and the
+bias-corrected (reliability weights) estimates are available.
+*/
+
+typedef struct rs_ewm {
+        double alpha;
+        bool adjust;
+        size_t count;
+        double mean;
+        double S;
+        double sum_w;
+        double sum_w2;
+} rs_ewm;
+
+/* out of range span/halflife/com give an alpha outside (0, 1], which
+   rs_ewm_init and the allocs below refuse with -1 / NULL */
+double rs_ewm_alpha_from_span(double span);
+double rs_ewm_alpha_from_halflife(double halflife);
+double rs_ewm_alpha_from_com(double com);
+
+rs_ewm *rs_ewm_alloc(double alpha, bool adjust);
+void rs_ewm_free(rs_ewm *e);
+int rs_ewm_init(rs_ewm *e, double alpha, bool adjust);
+void rs_ewm_reset(rs_ewm *e);
+void rs_ewm_update(rs_ewm *e, double item);
+void rs_ewm_update_batch(rs_ewm *e, const double *items, size_t length);
+
+static inline double rs_ewm_mean(rs_ewm *e) { return e->mean; }
+static inline double rs_ewm_variance_biased(rs_ewm *e) {
+        return (e->S / e->sum_w);
+}
+/* bias corrected, 0/0 until two samples have been seen */
+static inline double rs_ewm_variance(rs_ewm *e) {
+        double num = e->sum_w * e->sum_w;
+        return (e->S / e->sum_w) * (num / (num - e->sum_w2));
+}
+static inline double rs_ewm_stddev(rs_ewm *e) {
+        return sqrt(rs_ewm_variance(e));
+}
+
+/* EW counterpart of rs_rolling: one output slot per source sample, only
+   RS_STAT_MEAN, RS_STAT_VARIANCE and RS_STAT_STDDEV apply */
+typedef struct rs_ewm_rolling {
+        size_t count;
+        unsigned int stats;
+        rs_ewm ewm;
+        rs_vector *source_data;
+        rs_vector *means;
+        rs_vector *variances;
+        rs_vector *stddevs;
+} rs_ewm_rolling;
+
+rs_ewm_rolling *rs_ewm_rolling_alloc(rs_vector *v, double alpha, bool adjust,
+                                     unsigned int stats);
+void rs_ewm_rolling_free(rs_ewm_rolling *r);
+int rs_ewm_rolling_roll(rs_ewm_rolling *r, size_t start_index);
+
+#endif
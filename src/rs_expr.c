@@ -0,0 +1,264 @@
+#include "rs_expr.h"
+#include <stdio.h>
+#include <string.h>
+#include "rs_simd.h"
+
+/* doubles per evaluation block, small enough for max_depth scratch blocks
+   plus the operands to stay in L1/L2 */
+#define RS_EXPR_BLOCK 512
+
+typedef struct rs_expr_slot {
+        const double *data;
+        double scalar;
+        bool is_scalar;
+} rs_expr_slot;
+
+rs_expr *rs_expr_alloc(void) {
+        rs_expr *e = malloc(sizeof(rs_expr));
+        if (!e) {
+                fprintf(stderr, "[rs_expr_alloc] malloc error\n");
+                return NULL;
+        }
+        e->capacity = 8;
+        e->code = malloc(e->capacity * sizeof(rs_expr_instr));
+        if (!e->code) {
+                fprintf(stderr, "[rs_expr_alloc] malloc error\n");
+                free(e);
+                return NULL;
+        }
+        rs_expr_reset(e);
+        return e;
+}
+
+void rs_expr_free(rs_expr *e) {
+        if (e) {
+                if (e->code) {
+                        free(e->code);
+                }
+                free(e);
+                e = NULL;
+        }
+}
+
+void rs_expr_reset(rs_expr *e) {
+        e->length = 0;
+        e->depth = 0;
+        e->max_depth = 0;
+        e->count = 0;
+        e->error = false;
+}
+
+static int rs_expr_emit(rs_expr *e, rs_expr_instr instr) {
+        if (e->length == e->capacity) {
+                size_t capacity = e->capacity * CAPACITY_INCREASE_FACTOR;
+                rs_expr_instr *code =
+                    realloc(e->code, capacity * sizeof(rs_expr_instr));
+                if (!code) {
+                        fprintf(stderr, "[rs_expr_emit] realloc error\n");
+                        e->error = true;
+                        return -1;
+                }
+                e->code = code;
+                e->capacity = capacity;
+        }
+        e->code[e->length++] = instr;
+        return 0;
+}
+
+int rs_expr_push_vector(rs_expr *e, rs_vector *v) {
+        bool first = true;
+
+        if (!rs_vector_check_data("rs_expr_push_vector", v)) {
+                e->error = true;
+                return -1;
+        }
+        for (size_t i = 0; i < e->length; i++) {
+                if (e->code[i].op == RS_EXPR_VECTOR)
+                        first = false;
+        }
+        if (!first && v->count != e->count) {
+                fprintf(stderr,
+                        "[rs_expr_push_vector] length %zu != expression "
+                        "length %zu\n",
+                        v->count, e->count);
+                e->error = true;
+                return -1;
+        }
+        e->count = v->count;
+        if (rs_expr_emit(e, (rs_expr_instr){RS_EXPR_VECTOR, v, 0.0}) != 0)
+                return -1;
+        if (++e->depth > e->max_depth)
+                e->max_depth = e->depth;
+        return 0;
+}
+
+int rs_expr_push_scalar(rs_expr *e, double k) {
+        if (rs_expr_emit(e, (rs_expr_instr){RS_EXPR_SCALAR, NULL, k}) != 0)
+                return -1;
+        if (++e->depth > e->max_depth)
+                e->max_depth = e->depth;
+        return 0;
+}
+
+static int rs_expr_binary(rs_expr *e, rs_expr_opcode op) {
+        if (e->depth < 2) {
+                fprintf(stderr, "[rs_expr_binary] stack underflow\n");
+                e->error = true;
+                return -1;
+        }
+        if (rs_expr_emit(e, (rs_expr_instr){op, NULL, 0.0}) != 0)
+                return -1;
+        e->depth--;
+        return 0;
+}
+
+int rs_expr_add(rs_expr *e) { return rs_expr_binary(e, RS_EXPR_ADD); }
+int rs_expr_sub(rs_expr *e) { return rs_expr_binary(e, RS_EXPR_SUB); }
+int rs_expr_mul(rs_expr *e) { return rs_expr_binary(e, RS_EXPR_MUL); }
+int rs_expr_div(rs_expr *e) { return rs_expr_binary(e, RS_EXPR_DIV); }
+
+static double rs_expr_apply(rs_expr_opcode op, double a, double b) {
+        switch (op) {
+        case RS_EXPR_ADD:
+                return a + b;
+        case RS_EXPR_SUB:
+                return a - b;
+        case RS_EXPR_MUL:
+                return a * b;
+        default:
+                return a / b;
+        }
+}
+
+/* the op is hoisted out of the loops so each one vectorises */
+#define RS_EXPR_LOOPS(op)                                                      \
+        if (a->is_scalar) {                                                    \
+                for (size_t i = 0; i < n; i++)                                 \
+                        dst[i] = a->scalar op b->data[i];                      \
+        } else if (b->is_scalar) {                                             \
+                for (size_t i = 0; i < n; i++)                                 \
+                        dst[i] = a->data[i] op b->scalar;                      \
+        } else {                                                               \
+                for (size_t i = 0; i < n; i++)                                 \
+                        dst[i] = a->data[i] op b->data[i];                     \
+        }
+
+static void rs_expr_block_op(rs_expr_opcode op, double *dst,
+                             const rs_expr_slot *a, const rs_expr_slot *b,
+                             size_t n) {
+        switch (op) {
+        case RS_EXPR_ADD:
+                RS_EXPR_LOOPS(+)
+                break;
+        case RS_EXPR_SUB:
+                RS_EXPR_LOOPS(-)
+                break;
+        case RS_EXPR_MUL:
+                RS_EXPR_LOOPS(*)
+                break;
+        default:
+                RS_EXPR_LOOPS(/)
+                break;
+        }
+}
+
+/* runs the program over elements [offset, offset + n), leaving the result
+   in out */
+static void rs_expr_block_eval(rs_expr *e, rs_expr_slot *stack,
+                               double *scratch, size_t offset, size_t n,
+                               double *out) {
+        size_t top = 0;
+
+        for (size_t pc = 0; pc < e->length; pc++) {
+                rs_expr_instr *in = &e->code[pc];
+
+                if (in->op == RS_EXPR_VECTOR) {
+                        stack[top++] = (rs_expr_slot){
+                            in->vector->data + offset, 0.0, false};
+                } else if (in->op == RS_EXPR_SCALAR) {
+                        stack[top++] = (rs_expr_slot){NULL, in->scalar, true};
+                } else {
+                        rs_expr_slot *a = &stack[top - 2];
+                        rs_expr_slot *b = &stack[top - 1];
+                        if (a->is_scalar && b->is_scalar) {
+                                a->scalar = rs_expr_apply(in->op, a->scalar,
+                                                          b->scalar);
+                        } else {
+                                double *dst = pc + 1 == e->length
+                                                  ? out
+                                                  : scratch + (top - 2) *
+                                                                  RS_EXPR_BLOCK;
+                                rs_expr_block_op(in->op, dst, a, b, n);
+                                *a = (rs_expr_slot){dst, 0.0, false};
+                        }
+                        top--;
+                }
+        }
+        if (stack[0].is_scalar) {
+                for (size_t i = 0; i < n; i++)
+                        out[i] = stack[0].scalar;
+        } else if (stack[0].data != out) {
+                memmove(out, stack[0].data, n * sizeof(double));
+        }
+}
+
+int rs_expr_eval_into(rs_expr *e, rs_vector *out) {
+        if (e->error || e->depth != 1) {
+                fprintf(stderr, "[rs_expr_eval_into] invalid expression\n");
+                return -1;
+        }
+        size_t count = e->count;
+
+        /* operands may have been reset or shrunk since they were pushed */
+        for (size_t pc = 0; pc < e->length; pc++) {
+                rs_vector *v = e->code[pc].vector;
+                if (e->code[pc].op == RS_EXPR_VECTOR && v->count < count) {
+                        fprintf(stderr,
+                                "[rs_expr_eval_into] operand length %zu < "
+                                "expression length %zu\n",
+                                v->count, count);
+                        return -1;
+                }
+        }
+        if (rs_vector_reserve(out, count) != 0) {
+                fprintf(stderr, "[rs_expr_eval_into] realloc error\n");
+                return -1;
+        }
+        rs_expr_slot *stack = malloc(e->max_depth * sizeof(rs_expr_slot));
+        double *scratch = malloc(e->max_depth * RS_EXPR_BLOCK * sizeof(double));
+        if (!stack || !scratch) {
+                fprintf(stderr, "[rs_expr_eval_into] malloc error\n");
+                free(stack);
+                free(scratch);
+                return -1;
+        }
+
+        rs_stats s, b;
+        rs_stats_reset(&s);
+        for (size_t offset = 0; offset < count; offset += RS_EXPR_BLOCK) {
+                size_t n = count - offset < RS_EXPR_BLOCK ? count - offset
+                                                          : RS_EXPR_BLOCK;
+                rs_expr_block_eval(e, stack, scratch, offset, n,
+                                   out->data + offset);
+                rs_simd_block_stats(out->data + offset, n, &b);
+                rs_stats_combine(&s, &b);
+        }
+        s.count = count;
+        rs_vector_set_stats(out, &s);
+        free(stack);
+        free(scratch);
+        return 0;
+}
+
+rs_vector *rs_expr_eval(rs_expr *e) {
+        rs_vector *out = rs_vector_alloc(e->count);
+        if (!out) {
+                fprintf(stderr, "[rs_expr_eval] malloc error\n");
+                return NULL;
+        }
+        if (rs_expr_eval_into(e, out) != 0) {
+                rs_vector_free(out);
+                return NULL;
+        }
+        return out;
+}
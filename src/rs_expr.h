@@ -0,0 +1,57 @@
+#ifndef __RS_EXPR_H_
+#define __RS_EXPR_H_
+
+#include "rs_vector.h"
+
+/*
+deferred element-wise arithmetic over rs_vectors. an expression is recorded
+as a small postfix (stack) program, e.g. (a + b) * c - d is
+
+        push a, push b, add, push c, mul, push d, sub
+
+and evaluated a cache-sized block at a time, so every operand is read once,
+intermediates never leave L1, and the result's running stats are gathered
+while each result block is still hot. no temporaries of the full length are
+created and the operands are never modified.
+*/
+
+typedef enum rs_expr_opcode {
+        RS_EXPR_VECTOR = 0,
+        RS_EXPR_SCALAR,
+        RS_EXPR_ADD,
+        RS_EXPR_SUB,
+        RS_EXPR_MUL,
+        RS_EXPR_DIV
+} rs_expr_opcode;
+
+typedef struct rs_expr_instr {
+        rs_expr_opcode op;
+        rs_vector *vector;
+        double scalar;
+} rs_expr_instr;
+
+typedef struct rs_expr {
+        rs_expr_instr *code;
+        size_t length;
+        size_t capacity;
+        size_t depth;
+        size_t max_depth;
+        size_t count;
+        bool error;
+} rs_expr;
+
+rs_expr *rs_expr_alloc(void);
+void rs_expr_free(rs_expr *e);
+void rs_expr_reset(rs_expr *e);
+int rs_expr_push_vector(rs_expr *e, rs_vector *v);
+int rs_expr_push_scalar(rs_expr *e, double k);
+int rs_expr_add(rs_expr *e);
+int rs_expr_sub(rs_expr *e);
+int rs_expr_mul(rs_expr *e);
+int rs_expr_div(rs_expr *e);
+
+/* materialise into a new vector, or into out (which may be an operand) */
+rs_vector *rs_expr_eval(rs_expr *e);
+int rs_expr_eval_into(rs_expr *e, rs_vector *out);
+
+#endif
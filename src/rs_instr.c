@@ -0,0 +1,126 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "rs_instr.h"
+#include <inttypes.h>
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef RS_INSTRUMENT
+
+__thread rs_instr_block rs_instr_local;
+
+static pthread_mutex_t rs_instr_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t rs_instr_once = PTHREAD_ONCE_INIT;
+static pthread_key_t rs_instr_key;
+static rs_instr_block *rs_instr_threads = NULL;
+/* what exited threads counted, and the totals at the last reset */
+static rs_instr_counters rs_instr_retired;
+static rs_instr_counters rs_instr_base;
+
+static void rs_instr_add(rs_instr_counters *dst, rs_instr_counters *src) {
+#define X(name) dst->name += __atomic_load_n(&src->name, __ATOMIC_RELAXED);
+        RS_INSTR_COUNTERS(X)
+#undef X
+}
+
+/* runs at thread exit, while the thread's block is still mapped */
+static void rs_instr_retire(void *arg) {
+        rs_instr_block *b = arg;
+
+        pthread_mutex_lock(&rs_instr_lock);
+        rs_instr_add(&rs_instr_retired, &b->counters);
+        for (rs_instr_block **p = &rs_instr_threads; *p; p = &(*p)->next) {
+                if (*p == b) {
+                        *p = b->next;
+                        break;
+                }
+        }
+        pthread_mutex_unlock(&rs_instr_lock);
+}
+
+static void rs_instr_create_key(void) {
+        if (pthread_key_create(&rs_instr_key, rs_instr_retire) != 0)
+                fprintf(stderr, "[rs_instr_register] no thread key, counts "
+                                "of exiting threads are lost\n");
+}
+
+void rs_instr_register(void) {
+        rs_instr_block *b = &rs_instr_local;
+
+        pthread_once(&rs_instr_once, rs_instr_create_key);
+        pthread_mutex_lock(&rs_instr_lock);
+        b->next = rs_instr_threads;
+        rs_instr_threads = b;
+        b->registered = true;
+        pthread_mutex_unlock(&rs_instr_lock);
+        pthread_setspecific(rs_instr_key, b);
+}
+
+bool rs_instr_enabled(void) {
+        return true;
+}
+
+static void rs_instr_total(rs_instr_counters *out) {
+        *out = rs_instr_retired;
+        for (rs_instr_block *b = rs_instr_threads; b; b = b->next)
+                rs_instr_add(out, &b->counters);
+}
+
+void rs_instr_snapshot(rs_instr_counters *out) {
+        pthread_mutex_lock(&rs_instr_lock);
+        rs_instr_total(out);
+#define X(name) out->name -= rs_instr_base.name;
+        RS_INSTR_COUNTERS(X)
+#undef X
+        pthread_mutex_unlock(&rs_instr_lock);
+}
+
+void rs_instr_reset(void) {
+        pthread_mutex_lock(&rs_instr_lock);
+        rs_instr_total(&rs_instr_base);
+        pthread_mutex_unlock(&rs_instr_lock);
+}
+
+#else
+
+bool rs_instr_enabled(void) {
+        return false;
+}
+
+void rs_instr_snapshot(rs_instr_counters *out) {
+        memset(out, 0, sizeof(*out));
+}
+
+void rs_instr_reset(void) {
+}
+
+#endif
+
+#if defined(RS_INSTRUMENT_TIMING) && !defined(__x86_64__) && !defined(__i386__)
+uint64_t rs_instr_ticks(void) {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+#endif
+
+int rs_instr_dump_json(FILE *f) {
+        rs_instr_counters c;
+        const char *unit = "none";
+
+#ifdef RS_INSTRUMENT_TIMING
+#if defined(__x86_64__) || defined(__i386__)
+        unit = "tsc";
+#else
+        unit = "ns";
+#endif
+#endif
+        rs_instr_snapshot(&c);
+        fprintf(f, "{\"enabled\": %s, \"tick_unit\": \"%s\"",
+                rs_instr_enabled() ? "true" : "false", unit);
+#define X(name) fprintf(f, ", \"" #name "\": %" PRIu64, c.name);
+        RS_INSTR_COUNTERS(X)
+#undef X
+        return fprintf(f, "}\n") < 0 ? -1 : 0;
+}
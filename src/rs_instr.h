@@ -0,0 +1,114 @@
+#ifndef __RS_INSTR_H_
+#define __RS_INSTR_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+hot-path instrumentation, compiled in with -DRS_INSTRUMENT (make
+INSTRUMENT=1) and with timing added by -DRS_INSTRUMENT_TIMING (make
+INSTRUMENT=timing). without them every RS_INSTR_* macro expands to nothing
+and the snapshot API reports zeros, so a normal build pays nothing.
+
+each thread bumps its own __thread block, registered in a global list on
+first use, so counting takes no lock and shares no cache line. a snapshot
+sums the live blocks plus what exited threads left behind. the blocks are
+written and read with relaxed atomics, plain loads and stores on x86-64,
+so a snapshot never sees a torn value but may miss the latest increments.
+a reset records a baseline that later snapshots subtract, which leaves the
+other threads' blocks alone. counts are kept per call rather than per
+element, eviction counts included, so the kernels' inner loops are not
+touched. timing is in rdtsc ticks on x86 and nanoseconds elsewhere.
+*/
+
+/* X(name) for every counter */
+#define RS_INSTR_COUNTERS(X)                                                   \
+        X(pushes)                                                              \
+        X(resizes)                                                             \
+        X(resize_bytes)                                                        \
+        X(rolls)                                                               \
+        X(roll_windows)                                                        \
+        X(window_pushes)                                                       \
+        X(evictions)                                                           \
+        X(elementwise_ops)                                                     \
+        X(elementwise_items)                                                   \
+        X(resize_ticks)                                                        \
+        X(roll_ticks)                                                          \
+        X(elementwise_ticks)
+
+typedef struct rs_instr_counters {
+#define X(name) uint64_t name;
+        RS_INSTR_COUNTERS(X)
+#undef X
+} rs_instr_counters;
+
+/* true when compiled with RS_INSTRUMENT */
+bool rs_instr_enabled(void);
+/* sums every thread's counters since the last reset */
+void rs_instr_snapshot(rs_instr_counters *out);
+void rs_instr_reset(void);
+/* one JSON object holding the snapshot and the tick unit */
+int rs_instr_dump_json(FILE *f);
+
+#if defined(RS_INSTRUMENT_TIMING) && !defined(RS_INSTRUMENT)
+#define RS_INSTRUMENT
+#endif
+
+#ifdef RS_INSTRUMENT
+
+typedef struct rs_instr_block {
+        rs_instr_counters counters;
+        struct rs_instr_block *next;
+        bool registered;
+} rs_instr_block;
+
+extern __thread rs_instr_block rs_instr_local;
+
+void rs_instr_register(void);
+
+static inline rs_instr_counters *rs_instr_counters_local(void) {
+        if (__builtin_expect(!rs_instr_local.registered, 0))
+                rs_instr_register();
+        return &rs_instr_local.counters;
+}
+
+/* only the owning thread writes, so a relaxed load and store suffice */
+#define RS_INSTR_ADD(name, n)                                                  \
+        do {                                                                   \
+                uint64_t *rs_instr_slot = &rs_instr_counters_local()->name;    \
+                __atomic_store_n(rs_instr_slot,                                \
+                                 __atomic_load_n(rs_instr_slot,                \
+                                                 __ATOMIC_RELAXED) +           \
+                                     (uint64_t)(n),                            \
+                                 __ATOMIC_RELAXED);                            \
+        } while (0)
+
+#else
+
+/* n is not evaluated, sizeof only keeps its operands from going unused */
+#define RS_INSTR_ADD(name, n) ((void)sizeof(n))
+
+#endif
+
+#ifdef RS_INSTRUMENT_TIMING
+
+#if defined(__x86_64__) || defined(__i386__)
+static inline uint64_t rs_instr_ticks(void) {
+        return __builtin_ia32_rdtsc();
+}
+#else
+uint64_t rs_instr_ticks(void);
+#endif
+
+#define RS_INSTR_TIME_BEGIN(var) uint64_t var = rs_instr_ticks()
+#define RS_INSTR_TIME_END(var, name) RS_INSTR_ADD(name, rs_instr_ticks() - var)
+
+#else
+
+#define RS_INSTR_TIME_BEGIN(var) ((void)0)
+#define RS_INSTR_TIME_END(var, name) ((void)0)
+
+#endif
+
+#endif
@@ -0,0 +1,346 @@
+#define _DEFAULT_SOURCE
+#include "rs_io.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* columns are mapped in place, so the file byte order must be the host's */
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "rs_io requires a little-endian host"
+#endif
+
+static void rs_io_view(rs_vector *v, const double *data, size_t count) {
+        v->calc = false;
+        v->last_calc_index = 0;
+        v->min = 0.0;
+        v->max = 0.0;
+        v->sum = 0.0;
+        v->mean = 0.0;
+        v->M2 = 0.0;
+        v->M3 = 0.0;
+        v->M4 = 0.0;
+        v->count = count;
+        v->capacity = count;
+        v->data = (double *)data;
+        v->policy = rs_vector_policy_default;
+        v->policy.shrink = 0.0;
+        /* the mapping is PROT_READ, reset and pop must not clear it */
+        v->policy.zero = false;
+        v->policy.allocator = &rs_allocator_fixed;
+        v->latch = NULL;
+        v->sketch = NULL;
+        v->prefix = NULL;
+        v->prefix_capacity = 0;
+        v->prefix_count = 0;
+}
+
+static int rs_io_map_file(const char *path, size_t column, int advice,
+                          rs_io_mapping *m) {
+        int rc = -1;
+        struct stat st;
+        int fd = open(path, O_RDONLY);
+
+        m->map = NULL;
+        if (fd < 0) {
+                fprintf(stderr, "[rs_io_map_file] cannot open %s\n", path);
+                return -1;
+        }
+        if (fstat(fd, &st) != 0 || st.st_size == 0) {
+                fprintf(stderr, "[rs_io_map_file] %s is empty or unreadable\n",
+                        path);
+                goto out;
+        }
+        m->map_length = (size_t)st.st_size;
+        m->map = mmap(NULL, m->map_length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (m->map == MAP_FAILED) {
+                fprintf(stderr, "[rs_io_map_file] mmap error\n");
+                m->map = NULL;
+                goto out;
+        }
+        madvise(m->map, m->map_length, advice);
+
+        const rs_io_header *h = m->map;
+        if (m->map_length >= RS_IO_HEADER_SIZE &&
+            memcmp(h->magic, RS_IO_MAGIC, sizeof(h->magic)) == 0) {
+                if (h->version != RS_IO_VERSION ||
+                    h->data_offset % sizeof(double) != 0 ||
+                    h->data_offset > m->map_length ||
+                    (m->map_length - h->data_offset) / sizeof(double) /
+                            (h->n_columns ? h->n_columns : 1) <
+                        h->n_rows) {
+                        fprintf(stderr,
+                                "[rs_io_map_file] %s: bad header\n", path);
+                        goto out;
+                }
+                m->n_columns = h->n_columns;
+                m->n_rows = h->n_rows;
+                m->columns = (const double *)((const char *)m->map +
+                                              h->data_offset);
+        } else {
+                if (m->map_length % sizeof(double) != 0) {
+                        fprintf(stderr,
+                                "[rs_io_map_file] %s: size is not a multiple "
+                                "of %zu\n",
+                                path, sizeof(double));
+                        goto out;
+                }
+                m->n_columns = 1;
+                m->n_rows = m->map_length / sizeof(double);
+                m->columns = m->map;
+        }
+        if (column >= m->n_columns) {
+                fprintf(stderr, "[rs_io_map_file] column %zu out of range %zu\n",
+                        column, m->n_columns);
+                goto out;
+        }
+        rs_io_view(&m->vector, m->columns + column * m->n_rows, m->n_rows);
+        rc = 0;
+out:
+        /* the mapping keeps its own reference to the file */
+        close(fd);
+        if (rc != 0 && m->map) {
+                munmap(m->map, m->map_length);
+                m->map = NULL;
+        }
+        return rc;
+}
+
+rs_vector *rs_vector_map(const char *path, size_t column) {
+        rs_io_mapping *m = malloc(sizeof(rs_io_mapping));
+        if (!m) {
+                fprintf(stderr, "[rs_vector_map] malloc error\n");
+                return NULL;
+        }
+        if (rs_io_map_file(path, column, MADV_NORMAL, m) != 0) {
+                free(m);
+                return NULL;
+        }
+        return &m->vector;
+}
+
+void rs_vector_unmap(rs_vector *v) {
+        if (v) {
+                rs_io_mapping *m = (rs_io_mapping *)v;
+                munmap(m->map, m->map_length);
+                free(m);
+                m = NULL;
+        }
+}
+
+rs_io_reader *rs_io_reader_open(const char *path, size_t column,
+                                size_t chunk) {
+        if (chunk == 0) {
+                fprintf(stderr, "[rs_io_reader_open] chunk must be > 0\n");
+                return NULL;
+        }
+        rs_io_reader *rd = malloc(sizeof(rs_io_reader));
+        if (!rd) {
+                fprintf(stderr, "[rs_io_reader_open] malloc error\n");
+                return NULL;
+        }
+        if (rs_io_map_file(path, column, MADV_SEQUENTIAL, &rd->mapping) != 0) {
+                free(rd);
+                return NULL;
+        }
+        rd->data = rd->mapping.vector.data;
+        rd->n_items = rd->mapping.vector.count;
+        rd->chunk = chunk;
+        rd->overlap = 0;
+        rs_io_reader_rewind(rd);
+        return rd;
+}
+
+void rs_io_reader_close(rs_io_reader *rd) {
+        if (rd) {
+                munmap(rd->mapping.map, rd->mapping.map_length);
+                free(rd);
+                rd = NULL;
+        }
+}
+
+void rs_io_reader_rewind(rs_io_reader *rd) {
+        rd->position = 0;
+        rd->released = 0;
+        rs_io_view(&rd->mapping.vector, rd->data, 0);
+}
+
+rs_vector *rs_io_reader_view(rs_io_reader *rd) { return &rd->mapping.vector; }
+
+rs_vector *rs_io_reader_next(rs_io_reader *rd) {
+        if (rd->position >= rd->n_items) {
+                return NULL;
+        }
+        size_t start = rd->position > rd->overlap ? rd->position - rd->overlap
+                                                  : 0;
+        size_t end = rd->n_items - rd->position > rd->chunk
+                         ? rd->position + rd->chunk
+                         : rd->n_items;
+        char *base = rd->mapping.map;
+        size_t page = (size_t)sysconf(_SC_PAGESIZE);
+
+        /* drop whole pages nothing will look at again */
+        size_t used = (size_t)((const char *)(rd->data + start) - base);
+        used -= used % page;
+        if (used > rd->released) {
+                madvise(base + rd->released, used - rd->released,
+                        MADV_DONTNEED);
+                rd->released = used;
+        }
+        /* and start reading the chunk after this one */
+        if (end < rd->n_items) {
+                size_t ahead = (size_t)((const char *)(rd->data + end) - base);
+                size_t length = rd->chunk * sizeof(double);
+                ahead -= ahead % page;
+                if (length > rd->mapping.map_length - ahead)
+                        length = rd->mapping.map_length - ahead;
+                madvise(base + ahead, length, MADV_WILLNEED);
+        }
+        rs_io_view(&rd->mapping.vector, rd->data + start, end - start);
+        rd->position = end;
+        return &rd->mapping.vector;
+}
+
+/*
+rolls r, allocated on rs_io_reader_view(rd), over the whole column. chunks
+overlap by window - 1 so the output is continuous, fn sees each chunk's
+outputs in r with first_output the index of the first one in the full
+series. the window is refilled once per chunk, so chunk should be well
+above the window. a chunk that fails to roll stops the pass with -1 before
+fn sees it.
+*/
+int rs_io_reader_roll(rs_io_reader *rd, rs_rolling *r, rs_io_rolling_fn fn,
+                      void *arg) {
+        if (r->source_data != rs_io_reader_view(rd)) {
+                fprintf(stderr,
+                        "[rs_io_reader_roll] rolling is not on the reader "
+                        "view\n");
+                return -1;
+        }
+        rs_vector *chunk;
+
+        rd->overlap = r->window - 1;
+        rs_io_reader_rewind(rd);
+        while ((chunk = rs_io_reader_next(rd))) {
+                if (rs_rolling_roll(r, 0) != 0)
+                        return -1;
+                if (r->count > 0)
+                        fn(r, (size_t)(chunk->data - rd->data), arg);
+        }
+        return 0;
+}
+
+int rs_io_write(const char *path, rs_vector **columns, size_t n_columns,
+                bool header) {
+        int rc = -1;
+        size_t n_rows = n_columns > 0 ? columns[0]->count : 0;
+
+        for (size_t c = 0; c < n_columns; c++) {
+                if (!rs_vector_check_data("rs_io_write", columns[c]))
+                        return -1;
+        }
+        for (size_t c = 1; c < n_columns; c++) {
+                if (columns[c]->count != n_rows) {
+                        fprintf(stderr,
+                                "[rs_io_write] column %zu has %zu rows, "
+                                "expected %zu\n",
+                                c, columns[c]->count, n_rows);
+                        return -1;
+                }
+        }
+        FILE *f = fopen(path, "wb");
+        if (!f) {
+                fprintf(stderr, "[rs_io_write] cannot open %s\n", path);
+                return -1;
+        }
+        if (header) {
+                unsigned char block[RS_IO_HEADER_SIZE] = {0};
+                rs_io_header h = {.version = RS_IO_VERSION,
+                                  .n_columns = (uint32_t)n_columns,
+                                  .n_rows = n_rows,
+                                  .data_offset = RS_IO_HEADER_SIZE};
+                memcpy(h.magic, RS_IO_MAGIC, sizeof(h.magic));
+                memcpy(block, &h, sizeof(h));
+                if (fwrite(block, 1, sizeof(block), f) != sizeof(block))
+                        goto out;
+        }
+        for (size_t c = 0; c < n_columns; c++) {
+                if (fwrite(columns[c]->data, sizeof(double), n_rows, f) !=
+                    n_rows)
+                        goto out;
+        }
+        rc = 0;
+out:
+        if (fclose(f) != 0)
+                rc = -1;
+        if (rc != 0)
+                fprintf(stderr, "[rs_io_write] write error on %s\n", path);
+        return rc;
+}
+
+int rs_io_write_mapped(const char *path, rs_vector **columns,
+                       size_t n_columns, bool header) {
+        int rc = -1;
+        size_t n_rows = n_columns > 0 ? columns[0]->count : 0;
+        size_t offset = header ? RS_IO_HEADER_SIZE : 0;
+
+        for (size_t c = 0; c < n_columns; c++) {
+                if (!rs_vector_check_data("rs_io_write_mapped", columns[c]))
+                        return -1;
+        }
+        for (size_t c = 1; c < n_columns; c++) {
+                if (columns[c]->count != n_rows) {
+                        fprintf(stderr,
+                                "[rs_io_write_mapped] column %zu has %zu "
+                                "rows, expected %zu\n",
+                                c, columns[c]->count, n_rows);
+                        return -1;
+                }
+        }
+        size_t length = offset + n_columns * n_rows * sizeof(double);
+        int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+                fprintf(stderr, "[rs_io_write_mapped] cannot open %s\n", path);
+                return -1;
+        }
+        if (length == 0) {
+                close(fd);
+                return 0;
+        }
+        if (ftruncate(fd, (off_t)length) != 0) {
+                fprintf(stderr, "[rs_io_write_mapped] cannot size %s\n", path);
+                close(fd);
+                return -1;
+        }
+        char *map = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+                         0);
+        if (map == MAP_FAILED) {
+                fprintf(stderr, "[rs_io_write_mapped] mmap error\n");
+                close(fd);
+                return -1;
+        }
+        madvise(map, length, MADV_SEQUENTIAL);
+        if (header) {
+                rs_io_header h = {.version = RS_IO_VERSION,
+                                  .n_columns = (uint32_t)n_columns,
+                                  .n_rows = n_rows,
+                                  .data_offset = RS_IO_HEADER_SIZE};
+                memcpy(h.magic, RS_IO_MAGIC, sizeof(h.magic));
+                memset(map, 0, RS_IO_HEADER_SIZE);
+                memcpy(map, &h, sizeof(h));
+        }
+        for (size_t c = 0; c < n_columns; c++) {
+                memcpy(map + offset, columns[c]->data,
+                       n_rows * sizeof(double));
+                offset += n_rows * sizeof(double);
+        }
+        rc = munmap(map, length);
+        if (close(fd) != 0)
+                rc = -1;
+        if (rc != 0)
+                fprintf(stderr, "[rs_io_write_mapped] write error on %s\n",
+                        path);
+        return rc;
+}
@@ -0,0 +1,80 @@
+#ifndef __RS_IO_H_
+#define __RS_IO_H_
+
+#include "rs_rolling.h"
+#include <stdint.h>
+
+/*
+binary series on disk. a file is either raw little-endian doubles, or the
+headered columnar format below: a 64 byte header followed by n_columns
+column-major blocks of n_rows doubles each, so every column is contiguous
+and can be mapped straight into an rs_vector without copying.
+*/
+
+#define RS_IO_MAGIC "RSVECTOR"
+#define RS_IO_VERSION 1
+#define RS_IO_HEADER_SIZE 64
+
+typedef struct rs_io_header {
+        char magic[8];
+        uint32_t version;
+        uint32_t n_columns;
+        uint64_t n_rows;
+        uint64_t data_offset;
+} rs_io_header;
+
+/* a whole file mapped read-only, the vector is a view into it */
+typedef struct rs_io_mapping {
+        rs_vector vector;
+        void *map;
+        size_t map_length;
+        size_t n_columns;
+        size_t n_rows;
+        const double *columns;
+} rs_io_mapping;
+
+/*
+read-only view of one column, valid until rs_vector_unmap. the view must not
+be pushed to, resized or passed to rs_vector_free. raw files have a single
+column.
+*/
+rs_vector *rs_vector_map(const char *path, size_t column);
+void rs_vector_unmap(rs_vector *v);
+
+/*
+streams one column through a window of the mapping chunk by chunk. each view
+holds the last overlap items of the previous chunk followed by up to chunk
+new ones, pages already consumed are released so the resident set stays at
+about one chunk however large the file is.
+*/
+typedef struct rs_io_reader {
+        rs_io_mapping mapping;
+        const double *data;
+        size_t n_items;
+        size_t position;
+        size_t chunk;
+        size_t overlap;
+        size_t released;
+} rs_io_reader;
+
+typedef void (*rs_io_rolling_fn)(rs_rolling *r, size_t first_output,
+                                 void *arg);
+
+rs_io_reader *rs_io_reader_open(const char *path, size_t column,
+                                size_t chunk);
+void rs_io_reader_close(rs_io_reader *rd);
+void rs_io_reader_rewind(rs_io_reader *rd);
+/* the vector every chunk is presented through, alloc rs_rolling on this */
+rs_vector *rs_io_reader_view(rs_io_reader *rd);
+rs_vector *rs_io_reader_next(rs_io_reader *rd);
+int rs_io_reader_roll(rs_io_reader *rd, rs_rolling *r, rs_io_rolling_fn fn,
+                      void *arg);
+
+/* columns must have equal counts, raw files hold the columns back to back */
+int rs_io_write(const char *path, rs_vector **columns, size_t n_columns,
+                bool header);
+/* same layout, written through a shared writable mapping of the file */
+int rs_io_write_mapped(const char *path, rs_vector **columns,
+                       size_t n_columns, bool header);
+
+#endif
@@ -0,0 +1,318 @@
+#include "rs_kll.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* no level is allowed less room than this, as in DataSketches */
+#define RS_KLL_MIN_WIDTH 8
+
+typedef struct rs_kll_item {
+        double value;
+        uint64_t weight;
+} rs_kll_item;
+
+static int rs_kll_compare(const void *a, const void *b) {
+        double x = *(const double *)a, y = *(const double *)b;
+        return (x > y) - (x < y);
+}
+
+static int rs_kll_item_compare(const void *a, const void *b) {
+        return rs_kll_compare(&((const rs_kll_item *)a)->value,
+                              &((const rs_kll_item *)b)->value);
+}
+
+/* level 0 is mostly compacted a few dozen items at a time, too few for qsort
+   to pay off */
+static void rs_kll_sort(double *items, size_t count) {
+        if (count > 64) {
+                qsort(items, count, sizeof(double), rs_kll_compare);
+                return;
+        }
+        for (size_t i = 1; i < count; i++) {
+                double x = items[i];
+                size_t j = i;
+                for (; j > 0 && items[j - 1] > x; j--)
+                        items[j] = items[j - 1];
+                items[j] = x;
+        }
+}
+
+/* room shrinks by 2/3 per level below the top one */
+static void rs_kll_set_room(rs_kll *s) {
+        double room = (double)s->k;
+
+        s->max_retained = 0;
+        for (size_t h = s->levels; h-- > 0;) {
+                s->room[h] = (size_t)ceil(room);
+                if (s->room[h] < RS_KLL_MIN_WIDTH)
+                        s->room[h] = RS_KLL_MIN_WIDTH;
+                s->max_retained += s->room[h];
+                room *= 2.0 / 3.0;
+        }
+}
+
+static int rs_kll_reserve(rs_kll_level *lv, size_t count) {
+        if (count <= lv->size)
+                return 0;
+        size_t size = lv->size * 2 > count ? lv->size * 2 : count;
+        double *items = realloc(lv->items, size * sizeof(double));
+        if (!items) {
+                fprintf(stderr, "[rs_kll_reserve] realloc error\n");
+                return -1;
+        }
+        lv->items = items;
+        lv->size = size;
+        return 0;
+}
+
+rs_kll *rs_kll_alloc(size_t k) {
+        if (k < RS_KLL_MIN_K) {
+                fprintf(stderr, "[rs_kll_alloc] k must be >= %d\n",
+                        RS_KLL_MIN_K);
+                return NULL;
+        }
+        rs_kll *s = calloc(1, sizeof(rs_kll));
+        if (!s) {
+                fprintf(stderr, "[rs_kll_alloc] malloc error\n");
+                return NULL;
+        }
+        s->k = k;
+        rs_kll_reset(s);
+        if (rs_kll_reserve(&s->level[0], k) != 0) {
+                rs_kll_free(s);
+                return NULL;
+        }
+        return s;
+}
+
+void rs_kll_free(rs_kll *s) {
+        if (s) {
+                for (size_t h = 0; h < RS_KLL_MAX_LEVELS; h++)
+                        free(s->level[h].items);
+                free(s);
+                s = NULL;
+        }
+}
+
+/* keeps the level buffers for reuse */
+void rs_kll_reset(rs_kll *s) {
+        for (size_t h = 0; h < RS_KLL_MAX_LEVELS; h++)
+                s->level[h].count = 0;
+        s->n = 0;
+        s->levels = 1;
+        s->retained = 0;
+        s->min = NAN;
+        s->max = NAN;
+        s->rng = 0x2545f4914f6cdd1dull;
+        rs_kll_set_room(s);
+}
+
+static int rs_kll_grow(rs_kll *s) {
+        if (s->levels == RS_KLL_MAX_LEVELS) {
+                fprintf(stderr, "[rs_kll_grow] too many levels\n");
+                return -1;
+        }
+        s->levels++;
+        rs_kll_set_room(s);
+        return 0;
+}
+
+static bool rs_kll_coin(rs_kll *s) {
+        uint64_t x = s->rng;
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        s->rng = x;
+        return x >> 63;
+}
+
+/* merges the sorted items into the sorted level, from the back in place */
+static int rs_kll_merge_sorted(rs_kll_level *lv, const double *items,
+                               size_t count) {
+        if (rs_kll_reserve(lv, lv->count + count) != 0)
+                return -1;
+        size_t i = lv->count, j = count, out = lv->count + count;
+
+        while (j > 0) {
+                if (i > 0 && lv->items[i - 1] > items[j - 1])
+                        lv->items[--out] = lv->items[--i];
+                else
+                        lv->items[--out] = items[--j];
+        }
+        lv->count += count;
+        return 0;
+}
+
+/* halves level h into h + 1, an odd item out stays behind */
+static int rs_kll_compact(rs_kll *s, size_t h) {
+        rs_kll_level *lv = &s->level[h];
+        size_t start = lv->count & 1;
+        size_t offset = rs_kll_coin(s);
+        size_t out = 0;
+
+        if (h + 1 == s->levels && rs_kll_grow(s) != 0)
+                return -1;
+        if (h == 0)
+                rs_kll_sort(lv->items, lv->count);
+        for (size_t i = start; i + 1 < lv->count; i += 2)
+                lv->items[start + out++] = lv->items[i + offset];
+        if (rs_kll_merge_sorted(&s->level[h + 1], lv->items + start, out) !=
+            0)
+                return -1;
+        lv->count = start;
+        s->retained -= out;
+        return 0;
+}
+
+static int rs_kll_compress(rs_kll *s) {
+        while (s->retained >= s->max_retained) {
+                size_t h = 0;
+                while (s->level[h].count < s->room[h])
+                        h++;
+                if (rs_kll_compact(s, h) != 0)
+                        return -1;
+        }
+        return 0;
+}
+
+int rs_kll_update(rs_kll *s, double item) {
+        rs_kll_level *lv = &s->level[0];
+
+        if (lv->count == lv->size && rs_kll_reserve(lv, lv->count + 1) != 0)
+                return -1;
+        lv->items[lv->count++] = item;
+        if (s->n == 0) {
+                s->min = item;
+                s->max = item;
+        } else {
+                if (item < s->min) s->min = item;
+                if (item > s->max) s->max = item;
+        }
+        s->n++;
+        if (++s->retained >= s->max_retained)
+                return rs_kll_compress(s);
+        return 0;
+}
+
+int rs_kll_merge(rs_kll *dst, const rs_kll *src) {
+        if (dst == src) {
+                fprintf(stderr, "[rs_kll_merge] cannot merge into itself\n");
+                return -1;
+        }
+        if (src->n == 0)
+                return 0;
+        while (dst->levels < src->levels) {
+                if (rs_kll_grow(dst) != 0)
+                        return -1;
+        }
+        for (size_t h = 0; h < src->levels; h++) {
+                const rs_kll_level *from = &src->level[h];
+                rs_kll_level *to = &dst->level[h];
+
+                if (h == 0) {
+                        if (rs_kll_reserve(to, to->count + from->count) != 0)
+                                return -1;
+                        memcpy(to->items + to->count, from->items,
+                               from->count * sizeof(double));
+                        to->count += from->count;
+                } else if (rs_kll_merge_sorted(to, from->items,
+                                               from->count) != 0) {
+                        return -1;
+                }
+                dst->retained += from->count;
+        }
+        if (dst->n == 0 || src->min < dst->min)
+                dst->min = src->min;
+        if (dst->n == 0 || src->max > dst->max)
+                dst->max = src->max;
+        dst->n += src->n;
+        return rs_kll_compress(dst);
+}
+
+int rs_kll_quantiles(const rs_kll *s, const double *q, size_t n, double *out) {
+        for (size_t j = 0; j < n; j++) {
+                if (!(q[j] >= 0.0 && q[j] <= 1.0)) {
+                        fprintf(stderr, "[rs_kll_quantiles] q must be in "
+                                        "[0, 1]\n");
+                        return -1;
+                }
+        }
+        if (s->n == 0) {
+                for (size_t j = 0; j < n; j++)
+                        out[j] = NAN;
+                return 0;
+        }
+        rs_kll_item *items = malloc(s->retained * sizeof(rs_kll_item));
+        if (!items) {
+                fprintf(stderr, "[rs_kll_quantiles] malloc error\n");
+                return -1;
+        }
+        size_t count = 0;
+
+        for (size_t h = 0; h < s->levels; h++) {
+                for (size_t i = 0; i < s->level[h].count; i++) {
+                        items[count].value = s->level[h].items[i];
+                        items[count++].weight = (uint64_t)1 << h;
+                }
+        }
+        qsort(items, count, sizeof(rs_kll_item), rs_kll_item_compare);
+        /* weights become inclusive cumulative weights */
+        for (size_t i = 1; i < count; i++)
+                items[i].weight += items[i - 1].weight;
+
+        for (size_t j = 0; j < n; j++) {
+                double target = q[j] * (double)s->n;
+                size_t lo = 0, hi = count - 1;
+
+                if (q[j] == 0.0) {
+                        out[j] = s->min;
+                        continue;
+                }
+                if (q[j] == 1.0) {
+                        out[j] = s->max;
+                        continue;
+                }
+                /* first item whose cumulative weight reaches the target */
+                while (lo < hi) {
+                        size_t mid = lo + (hi - lo) / 2;
+                        if ((double)items[mid].weight < target)
+                                lo = mid + 1;
+                        else
+                                hi = mid;
+                }
+                out[j] = items[lo].value;
+        }
+        free(items);
+        return 0;
+}
+
+double rs_kll_quantile(const rs_kll *s, double q) {
+        double out;
+
+        if (rs_kll_quantiles(s, &q, 1, &out) != 0)
+                return NAN;
+        return out;
+}
+
+double rs_kll_rank(const rs_kll *s, double item) {
+        uint64_t weight = 0;
+
+        if (s->n == 0)
+                return NAN;
+        for (size_t h = 0; h < s->levels; h++) {
+                for (size_t i = 0; i < s->level[h].count; i++) {
+                        if (s->level[h].items[i] <= item)
+                                weight += (uint64_t)1 << h;
+                }
+        }
+        return (double)weight / (double)s->n;
+}
+
+size_t rs_kll_bytes(const rs_kll *s) {
+        size_t bytes = sizeof(rs_kll);
+
+        for (size_t h = 0; h < RS_KLL_MAX_LEVELS; h++)
+                bytes += s->level[h].size * sizeof(double);
+        return bytes;
+}
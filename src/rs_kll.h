@@ -0,0 +1,60 @@
+#ifndef __RS_KLL_H_
+#define __RS_KLL_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+KLL quantile sketch (Karnin, Lang, Liberty, "Optimal Quantile Approximation
+in Streams", FOCS 2016) in the lazy form of Ivkin et al. level h holds
+items of weight 2^h with room for about k (2/3)^(depth) of them. when the
+sketch as a whole is full, the lowest level over its room is sorted and
+every other item, from a random offset, is promoted to the level above.
+the rank error is O(1 / k) with about 3k items kept whatever the stream
+length (worst percentile about 1.1% at k = 100 and 0.6% at k = 200 over
+1e6 items, see bench/quantile_sketch.c). sketches merge level by level, so
+shards or threads can be summarised separately and combined. min and max
+are exact.
+*/
+
+#define RS_KLL_DEFAULT_K 200
+#define RS_KLL_MIN_K 8
+#define RS_KLL_MAX_LEVELS 60
+
+typedef struct rs_kll_level {
+        double *items;
+        size_t count;
+        size_t size;
+} rs_kll_level;
+
+typedef struct rs_kll {
+        size_t k;
+        size_t n;
+        size_t levels;
+        size_t retained;
+        size_t max_retained;
+        double min;
+        double max;
+        uint64_t rng;
+        /* levels above 0 are kept sorted */
+        rs_kll_level level[RS_KLL_MAX_LEVELS];
+        size_t room[RS_KLL_MAX_LEVELS];
+} rs_kll;
+
+rs_kll *rs_kll_alloc(size_t k);
+void rs_kll_free(rs_kll *s);
+void rs_kll_reset(rs_kll *s);
+int rs_kll_update(rs_kll *s, double item);
+/* folds src into dst, src is left unchanged. dst keeps its own k */
+int rs_kll_merge(rs_kll *dst, const rs_kll *src);
+/* approximate q-quantile, q in [0, 1]. NAN when empty */
+double rs_kll_quantile(const rs_kll *s, double q);
+/* n quantiles at once from one pass over the sketch */
+int rs_kll_quantiles(const rs_kll *s, const double *q, size_t n, double *out);
+/* approximate fraction of the stream <= item */
+double rs_kll_rank(const rs_kll *s, double item);
+/* bytes held by the sketch, struct included */
+size_t rs_kll_bytes(const rs_kll *s);
+
+#endif
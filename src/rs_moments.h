@@ -0,0 +1,293 @@
+#ifndef __RS_MOMENTS_H_
+#define __RS_MOMENTS_H_
+
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#if defined(__GNUC__)
+#define RS_ALWAYS_INLINE inline __attribute__((always_inline))
+#else
+#define RS_ALWAYS_INLINE inline
+#endif
+
+/* keeps -Ofast (-fassociative-math) from folding compensation terms away */
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 12
+#define RS_ASSOC_BARRIER(x) __builtin_assoc_barrier(x)
+#elif defined(__clang__) && __clang_major__ >= 12
+#define RS_ASSOC_BARRIER(x) __arithmetic_fence(x)
+#else
+#define RS_ASSOC_BARRIER(x) (x)
+#endif
+
+/*
+central moment accumulator shared by the windowed structures. order selects
+how many moments are maintained (1: sum/mean, 2: +M2, 3: +M3, 4: +M4) and
+compensated switches sum and mean to Neumaier summation, keeping the running
+error in sum_c/mean_c. both are meant to be compile-time constants so unused
+moments and compensation cost nothing.
+*/
+
+typedef struct rs_moments {
+        double sum;
+        double mean;
+        double M2;
+        double M3;
+        double M4;
+        double sum_c;
+        double mean_c;
+} rs_moments;
+
+static inline void rs_moments_reset(rs_moments *m) {
+        m->sum = 0.0;
+        m->mean = 0.0;
+        m->M2 = 0.0;
+        m->M3 = 0.0;
+        m->M4 = 0.0;
+        m->sum_c = 0.0;
+        m->mean_c = 0.0;
+}
+
+/* Neumaier's improved Kahan-Babuska summation, *s + *c is the total */
+static RS_ALWAYS_INLINE void rs_neumaier_add(double *s, double *c, double x) {
+        double t = RS_ASSOC_BARRIER(*s + x);
+        if (fabs(*s) >= fabs(x))
+                *c += RS_ASSOC_BARRIER(RS_ASSOC_BARRIER(*s - t) + x);
+        else
+                *c += RS_ASSOC_BARRIER(RS_ASSOC_BARRIER(x - t) + *s);
+        *s = t;
+}
+
+static inline double rs_moments_sum(const rs_moments *m) {
+        return m->sum + m->sum_c;
+}
+
+static inline double rs_moments_mean(const rs_moments *m) {
+        return m->mean + m->mean_c;
+}
+
+/* n is the count including item */
+static RS_ALWAYS_INLINE void rs_moments_put(rs_moments *m, double item,
+                                            double n, int order,
+                                            bool compensated) {
+        if (order < 1)
+                return;
+        if (compensated)
+                rs_neumaier_add(&m->sum, &m->sum_c, item);
+        else
+                m->sum += item;
+
+        /* from GSL rstat and John D. Cook, MIT license
+            http://www.johndcook.com/blog/skewness_kurtosis/ */
+        double delta = item - (compensated ? rs_moments_mean(m) : m->mean);
+        double delta_n = delta / n;
+        double delta_nsq = delta_n * delta_n;
+        double term1 = delta * delta_n * (n - 1.0);
+        if (compensated)
+                rs_neumaier_add(&m->mean, &m->mean_c, delta_n);
+        else
+                m->mean += delta_n;
+        if (order >= 4)
+                m->M4 += term1 * delta_nsq * (n * n - 3.0 * n + 3.0) +
+                         6.0 * delta_nsq * m->M2 - 4.0 * delta_n * m->M3;
+        if (order >= 3)
+                m->M3 += term1 * delta_n * (n - 2.0) - 3.0 * delta_n * m->M2;
+        if (order >= 2)
+                m->M2 += term1;
+}
+
+/* n is the count excluding item, need to use n+1 in term1, M3/M4 */
+static RS_ALWAYS_INLINE void rs_moments_pop(rs_moments *m, double item,
+                                            double n, int order,
+                                            bool compensated) {
+        if (order < 1)
+                return;
+        if (n == 0.0) {
+                rs_moments_reset(m);
+                return;
+        }
+        if (compensated)
+                rs_neumaier_add(&m->sum, &m->sum_c, -item);
+        else
+                m->sum -= item;
+
+        double n1 = n + 1.0;
+        double delta = item - (compensated ? rs_moments_mean(m) : m->mean);
+        double delta_n = delta / n;
+        double delta_nsq = delta_n * delta_n;
+        double term1 = delta * delta_n * n1;
+        if (compensated)
+                rs_neumaier_add(&m->mean, &m->mean_c, -delta_n);
+        else
+                m->mean -= delta_n;
+        if (order >= 2) {
+                m->M2 -= term1;
+                /* cancellation can leave a tiny negative M2 */
+                if (compensated && m->M2 < 0.0)
+                        m->M2 = 0.0;
+        }
+        if (order >= 3)
+                m->M3 -= term1 * delta_n * (n1 - 2.0) - 3.0 * delta_n * m->M2;
+        if (order >= 4)
+                m->M4 -= term1 * delta_nsq * (n1 * n1 - 3.0 * n1 + 3.0) +
+                         6.0 * delta_nsq * m->M2 - 4.0 * delta_n * m->M3;
+}
+
+static inline double rs_moments_variance(const rs_moments *m, double n) {
+        return (m->M2 / (n - 1.0));
+}
+
+static inline double rs_moments_skewness(const rs_moments *m, double n) {
+        double fac = pow(n - 1.0, 1.5) / n;
+        return ((fac * m->M3) / pow(m->M2, 1.5));
+}
+
+static inline double rs_moments_kurtosis(const rs_moments *m, double n) {
+        double fac = ((n - 1.0) / n) * (n - 1.0);
+        return ((fac * m->M4) / (m->M2 * m->M2) - 3.0);
+}
+
+/*
+second order co-moments of paired samples: both means, both M2 and the
+co-moment C = sum (x - mean_x)(y - mean_y), with the same one-pass add and
+remove as rs_moments_put/pop (Welford's update applied to the cross term).
+*/
+
+typedef struct rs_comoments {
+        double mean_x;
+        double mean_y;
+        double M2x;
+        double M2y;
+        double C;
+} rs_comoments;
+
+static inline void rs_comoments_reset(rs_comoments *m) {
+        m->mean_x = 0.0;
+        m->mean_y = 0.0;
+        m->M2x = 0.0;
+        m->M2y = 0.0;
+        m->C = 0.0;
+}
+
+/* n is the count including the pair */
+static RS_ALWAYS_INLINE void rs_comoments_put(rs_comoments *m, double x,
+                                              double y, double n) {
+        double dx = x - m->mean_x;
+        double dy = y - m->mean_y;
+
+        m->mean_x += dx / n;
+        m->mean_y += dy / n;
+        m->M2x += dx * (x - m->mean_x);
+        m->M2y += dy * (y - m->mean_y);
+        m->C += dx * (y - m->mean_y);
+}
+
+/* n is the count excluding the pair */
+static RS_ALWAYS_INLINE void rs_comoments_pop(rs_comoments *m, double x,
+                                              double y, double n) {
+        if (n == 0.0) {
+                rs_comoments_reset(m);
+                return;
+        }
+        double dx = x - m->mean_x;
+        double dy = y - m->mean_y;
+
+        m->mean_x -= dx / n;
+        m->mean_y -= dy / n;
+        m->M2x -= dx * (x - m->mean_x);
+        m->M2y -= dy * (y - m->mean_y);
+        m->C -= dy * (x - m->mean_x);
+}
+
+static inline double rs_comoments_covariance(const rs_comoments *m, double n) {
+        return m->C / (n - 1.0);
+}
+
+static inline double rs_comoments_correlation(const rs_comoments *m) {
+        return m->C / sqrt(m->M2x * m->M2y);
+}
+
+/* least squares y = intercept + slope * x */
+static inline double rs_comoments_slope(const rs_comoments *m) {
+        return m->C / m->M2x;
+}
+
+static inline double rs_comoments_intercept(const rs_comoments *m) {
+        return m->mean_y - rs_comoments_slope(m) * m->mean_x;
+}
+
+/*
+summary of a whole sample, field-compatible with rs_vector. two summaries of
+disjoint samples combine exactly with the pairwise update of Chan et al. and
+Pebay (Sandia report SAND2008-6212) without revisiting the data.
+*/
+
+typedef struct rs_stats {
+        size_t count;
+        double min;
+        double max;
+        double sum;
+        double mean;
+        double M2;
+        double M3;
+        double M4;
+} rs_stats;
+
+static inline void rs_stats_reset(rs_stats *s) {
+        s->count = 0;
+        s->min = 0.0;
+        s->max = 0.0;
+        s->sum = 0.0;
+        s->mean = 0.0;
+        s->M2 = 0.0;
+        s->M3 = 0.0;
+        s->M4 = 0.0;
+}
+
+/* a = a U b */
+static inline void rs_stats_combine(rs_stats *a, const rs_stats *b) {
+        if (b->count == 0)
+                return;
+        if (a->count == 0) {
+                *a = *b;
+                return;
+        }
+        double na = (double)a->count;
+        double nb = (double)b->count;
+        double n = na + nb;
+        double delta = b->mean - a->mean;
+        double delta_n = delta / n;
+        double delta_nsq = delta_n * delta_n;
+
+        a->M4 += b->M4 +
+                 delta * delta_nsq * delta_n * na * nb *
+                     (na * na - na * nb + nb * nb) +
+                 6.0 * delta_nsq * (na * na * b->M2 + nb * nb * a->M2) +
+                 4.0 * delta_n * (na * b->M3 - nb * a->M3);
+        a->M3 += b->M3 + delta * delta_nsq * na * nb * (na - nb) +
+                 3.0 * delta_n * (na * b->M2 - nb * a->M2);
+        a->M2 += b->M2 + delta * delta_n * na * nb;
+        a->mean += nb * delta_n;
+        a->sum += b->sum;
+        a->count += b->count;
+        if (b->min < a->min)
+                a->min = b->min;
+        if (b->max > a->max)
+                a->max = b->max;
+}
+
+static inline double rs_stats_variance(const rs_stats *s) {
+        return (s->M2 / (s->count - 1.0));
+}
+
+static inline double rs_stats_skewness(const rs_stats *s) {
+        double fac = pow(s->count - 1.0, 1.5) / (s->count + 0.0);
+        return ((fac * s->M3) / pow(s->M2, 1.5));
+}
+
+static inline double rs_stats_kurtosis(const rs_stats *s) {
+        double fac = ((s->count - 1.0) / s->count) * (s->count - 1.0);
+        return ((fac * s->M4) / (s->M2 * s->M2) - 3.0);
+}
+
+#endif
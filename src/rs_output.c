@@ -0,0 +1,114 @@
+#include "rs_output.h"
+#include <string.h>
+#include "rs_d2s.h"
+#include "rs_io.h"
+
+#define RS_OUTPUT_MAX_COLUMNS (8 + RS_ROLLING_MAX_QUANTILES)
+
+/* gathers the selected series, returns how many or -1 if one is missing */
+static int rs_output_columns(rs_rolling *r, unsigned int columns,
+                             rs_vector **cols, const char **names) {
+        int n = 0;
+
+        if (columns == 0)
+                columns = r->stats | (r->n_quantiles ? RS_STAT_QUANTILES : 0);
+        if ((columns & ~r->stats & RS_STAT_ALL) ||
+            ((columns & RS_STAT_QUANTILES) && !r->n_quantiles)) {
+                fprintf(stderr,
+                        "[rs_output_columns] column not computed by this "
+                        "rolling\n");
+                return -1;
+        }
+#define X(flag, member, name)                                                  \
+        if (columns & flag) {                                                  \
+                cols[n] = r->member;                                           \
+                names[n] = name;                                               \
+                n++;                                                           \
+        }
+        RS_ROLLING_SERIES(X)
+#undef X
+        for (size_t q = 0; (columns & RS_STAT_QUANTILES) && q < r->n_quantiles;
+             q++) {
+                cols[n] = r->quantiles[q];
+                names[n] = r->quantile_names[q];
+                n++;
+        }
+        return n;
+}
+
+int rs_rolling_write_csv(rs_rolling *r, FILE *f, unsigned int columns) {
+        rs_vector *cols[RS_OUTPUT_MAX_COLUMNS];
+        const char *names[RS_OUTPUT_MAX_COLUMNS];
+        int n_cols = rs_output_columns(r, columns, cols, names);
+        if (n_cols < 0)
+                return -1;
+
+        char *buffer = malloc(RS_OUTPUT_BLOCK);
+        if (!buffer) {
+                fprintf(stderr, "[rs_rolling_write_csv] malloc error\n");
+                return -1;
+        }
+        /* one full row always fits behind the flush check */
+        size_t row_max = (size_t)n_cols * (RS_D2S_MAX_LENGTH + 1);
+        size_t used = 0;
+        int rc = 0;
+
+        for (int c = 0; c < n_cols; c++) {
+                if (c > 0)
+                        buffer[used++] = ',';
+                size_t length = strlen(names[c]);
+                memcpy(buffer + used, names[c], length);
+                used += length;
+        }
+        buffer[used++] = '\n';
+
+        for (size_t i = 0; i < r->count && rc == 0; i++) {
+                for (int c = 0; c < n_cols; c++) {
+                        used += rs_d2s(cols[c]->data[i], buffer + used);
+                        buffer[used++] = ',';
+                }
+                buffer[used - 1] = '\n';
+                if (used + row_max > RS_OUTPUT_BLOCK) {
+                        if (fwrite(buffer, 1, used, f) != used)
+                                rc = -1;
+                        used = 0;
+                }
+        }
+        if (rc == 0 && used > 0 && fwrite(buffer, 1, used, f) != used)
+                rc = -1;
+        if (rc != 0)
+                fprintf(stderr, "[rs_rolling_write_csv] write error\n");
+        free(buffer);
+        return rc;
+}
+
+int rs_rolling_write(rs_rolling *r, const char *path, rs_output_format format,
+                     unsigned int columns) {
+        int rc = -1;
+
+        if (format == RS_OUTPUT_CSV) {
+                FILE *f = fopen(path, "wb");
+                if (!f) {
+                        fprintf(stderr, "[rs_rolling_write] cannot open %s\n",
+                                path);
+                        return -1;
+                }
+                /* blocks are already large, skip stdio's copy */
+                setvbuf(f, NULL, _IONBF, 0);
+                rc = rs_rolling_write_csv(r, f, columns);
+                if (fclose(f) != 0)
+                        rc = -1;
+                return rc;
+        }
+
+        rs_vector *cols[RS_OUTPUT_MAX_COLUMNS];
+        const char *names[RS_OUTPUT_MAX_COLUMNS];
+        int n_cols = rs_output_columns(r, columns, cols, names);
+        if (n_cols < 0)
+                return -1;
+        if (format == RS_OUTPUT_MMAP)
+                rc = rs_io_write_mapped(path, cols, (size_t)n_cols, true);
+        else
+                rc = rs_io_write(path, cols, (size_t)n_cols, true);
+        return rc;
+}
@@ -0,0 +1,27 @@
+#ifndef __RS_OUTPUT_H_
+#define __RS_OUTPUT_H_
+
+#include <stdio.h>
+#include "rs_rolling.h"
+
+/* bytes of csv text formatted before each write */
+#define RS_OUTPUT_BLOCK (1u << 20)
+
+typedef enum rs_output_format {
+        RS_OUTPUT_CSV = 0,
+        RS_OUTPUT_BINARY,
+        RS_OUTPUT_MMAP
+} rs_output_format;
+
+/*
+writes the rolling output series selected by columns, a mask of RS_STAT_*
+flags (0 for every series r computed), in RS_ROLLING_SERIES order followed
+by the quantiles when RS_STAT_QUANTILES is set. csv has a header row and
+shortest round-trip values, the binary formats write the headered
+column-major layout of rs_io.h, readable with rs_vector_map.
+*/
+int rs_rolling_write(rs_rolling *r, const char *path, rs_output_format format,
+                     unsigned int columns);
+int rs_rolling_write_csv(rs_rolling *r, FILE *f, unsigned int columns);
+
+#endif
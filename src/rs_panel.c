@@ -0,0 +1,371 @@
+#include "rs_panel.h"
+#include "rs_simd.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define RS_PANEL_X86 1
+#endif
+
+/*
+the kernels are plain loops over the series with every pointer restrict and
+the count hoisted, so the compiler vectorises them; each (order, extrema)
+instantiation is compiled once per instruction set and picked with
+rs_simd_get_level. moments go through rs_moments_put/pop on a local copy,
+which keeps the arithmetic identical to the other rolling structures.
+*/
+
+typedef void (*rs_panel_kernel)(rs_panel *p, const double *rows,
+                                size_t n_rows);
+
+#define RS_PANEL_LOAD(m, i)                                                    \
+        rs_moments m = {sums[i], means[i], 0.0, 0.0, 0.0, 0.0, 0.0};           \
+        if (order >= 2)                                                        \
+                m.M2 = M2[i];                                                  \
+        if (order >= 3)                                                        \
+                m.M3 = M3[i];                                                  \
+        if (order >= 4)                                                        \
+                m.M4 = M4[i];
+
+#define RS_PANEL_STORE(m, i)                                                   \
+        sums[i] = m.sum;                                                       \
+        means[i] = m.mean;                                                     \
+        if (order >= 2)                                                        \
+                M2[i] = m.M2;                                                  \
+        if (order >= 3)                                                        \
+                M3[i] = m.M3;                                                  \
+        if (order >= 4)                                                        \
+                M4[i] = m.M4;
+
+static RS_ALWAYS_INLINE void
+rs_panel_cumulative_body(rs_panel *p, const double *rows, size_t n_rows,
+                         const int order, const bool extrema) {
+        const size_t n_series = p->n_series;
+        double *restrict mins = p->mins;
+        double *restrict maxs = p->maxs;
+        double *restrict sums = p->sums;
+        double *restrict means = p->means;
+        double *restrict M2 = p->M2;
+        double *restrict M3 = p->M3;
+        double *restrict M4 = p->M4;
+
+        for (size_t r = 0; r < n_rows; r++) {
+                const double *restrict x = rows + r * n_series;
+                double n = (double)++p->count;
+
+                if (extrema && p->count == 1) {
+                        for (size_t i = 0; i < n_series; i++) {
+                                mins[i] = x[i];
+                                maxs[i] = x[i];
+                        }
+                } else if (extrema) {
+                        for (size_t i = 0; i < n_series; i++) {
+                                mins[i] = x[i] < mins[i] ? x[i] : mins[i];
+                                maxs[i] = x[i] > maxs[i] ? x[i] : maxs[i];
+                        }
+                }
+                if (order >= 1) {
+                        for (size_t i = 0; i < n_series; i++) {
+                                RS_PANEL_LOAD(m, i)
+                                rs_moments_put(&m, x[i], n, order, false);
+                                RS_PANEL_STORE(m, i)
+                        }
+                }
+        }
+        p->seq += n_rows;
+}
+
+/* the moments of a full window pop the oldest row and put the new one in
+   the same sweep; extrema need a deque per series and stay scalar */
+static RS_ALWAYS_INLINE void
+rs_panel_rolling_body(rs_panel *p, const double *rows, size_t n_rows,
+                      const int order, const bool extrema) {
+        const size_t n_series = p->n_series;
+        const size_t window = p->window;
+        double *restrict sums = p->sums;
+        double *restrict means = p->means;
+        double *restrict M2 = p->M2;
+        double *restrict M3 = p->M3;
+        double *restrict M4 = p->M4;
+
+        for (size_t r = 0; r < n_rows; r++) {
+                const double *restrict x = rows + r * n_series;
+                double *restrict slot = p->ring + p->pos * n_series;
+
+                if (order >= 1 && p->count == window) {
+                        double n = (double)window;
+                        for (size_t i = 0; i < n_series; i++) {
+                                RS_PANEL_LOAD(m, i)
+                                rs_moments_pop(&m, slot[i], n - 1.0, order,
+                                               false);
+                                rs_moments_put(&m, x[i], n, order, false);
+                                RS_PANEL_STORE(m, i)
+                                slot[i] = x[i];
+                        }
+                } else if (order >= 1) {
+                        double n = (double)(p->count + 1);
+                        for (size_t i = 0; i < n_series; i++) {
+                                RS_PANEL_LOAD(m, i)
+                                rs_moments_put(&m, x[i], n, order, false);
+                                RS_PANEL_STORE(m, i)
+                                slot[i] = x[i];
+                        }
+                } else {
+                        for (size_t i = 0; i < n_series; i++)
+                                slot[i] = x[i];
+                }
+                if (extrema) {
+                        for (size_t i = 0; i < n_series; i++) {
+                                monotonic_deque *lo = p->min_deques[i];
+                                monotonic_deque *hi = p->max_deques[i];
+                                if (p->seq >= window) {
+                                        monotonic_deque_evict(lo,
+                                                              p->seq - window);
+                                        monotonic_deque_evict(hi,
+                                                              p->seq - window);
+                                }
+                                monotonic_deque_push(lo, x[i], p->seq);
+                                monotonic_deque_push(hi, x[i], p->seq);
+                                p->mins[i] = monotonic_deque_front(lo);
+                                p->maxs[i] = monotonic_deque_front(hi);
+                        }
+                }
+                if (p->count < window)
+                        p->count++;
+                if (++p->pos == window)
+                        p->pos = 0;
+                p->seq++;
+        }
+}
+
+#define RS_PANEL_KERNEL_DEFINE(isa, attributes, order, extrema)                \
+        attributes static void rs_panel_cumulative_##isa##_##order##_##extrema( \
+            rs_panel *p, const double *rows, size_t n_rows) {                  \
+                rs_panel_cumulative_body(p, rows, n_rows, order, extrema);     \
+        }                                                                      \
+        attributes static void rs_panel_rolling_##isa##_##order##_##extrema(   \
+            rs_panel *p, const double *rows, size_t n_rows) {                  \
+                rs_panel_rolling_body(p, rows, n_rows, order, extrema);        \
+        }
+
+#define RS_PANEL_KERNEL_ENTRY(isa, order, extrema)                             \
+        [0][order][extrema] = rs_panel_cumulative_##isa##_##order##_##extrema, \
+        [1][order][extrema] = rs_panel_rolling_##isa##_##order##_##extrema,
+
+#define RS_PANEL_DEFINE_BASE(order, extrema)                                   \
+        RS_PANEL_KERNEL_DEFINE(base, , order, extrema)
+#define RS_PANEL_ENTRY_BASE(order, extrema)                                    \
+        RS_PANEL_KERNEL_ENTRY(base, order, extrema)
+
+RS_ROLLING_KERNELS(RS_PANEL_DEFINE_BASE)
+
+static const rs_panel_kernel rs_panel_kernels_base[2][5][2] = {
+        RS_ROLLING_KERNELS(RS_PANEL_ENTRY_BASE)
+};
+
+#ifdef RS_PANEL_X86
+#define RS_PANEL_DEFINE_AVX2(order, extrema)                                   \
+        RS_PANEL_KERNEL_DEFINE(avx2, __attribute__((target("avx2,fma"))),     \
+                               order, extrema)
+#define RS_PANEL_ENTRY_AVX2(order, extrema)                                    \
+        RS_PANEL_KERNEL_ENTRY(avx2, order, extrema)
+#define RS_PANEL_DEFINE_AVX512(order, extrema)                                 \
+        RS_PANEL_KERNEL_DEFINE(avx512, __attribute__((target("avx512f"))),    \
+                               order, extrema)
+#define RS_PANEL_ENTRY_AVX512(order, extrema)                                  \
+        RS_PANEL_KERNEL_ENTRY(avx512, order, extrema)
+
+RS_ROLLING_KERNELS(RS_PANEL_DEFINE_AVX2)
+RS_ROLLING_KERNELS(RS_PANEL_DEFINE_AVX512)
+
+static const rs_panel_kernel rs_panel_kernels_avx2[2][5][2] = {
+        RS_ROLLING_KERNELS(RS_PANEL_ENTRY_AVX2)
+};
+
+static const rs_panel_kernel rs_panel_kernels_avx512[2][5][2] = {
+        RS_ROLLING_KERNELS(RS_PANEL_ENTRY_AVX512)
+};
+#endif
+
+static rs_panel_kernel rs_panel_kernel_get(rs_panel *p) {
+        bool rolling = p->window > 0;
+        int order = rs_stats_order(p->stats);
+        bool extrema = rs_stats_extrema(p->stats);
+
+#ifdef RS_PANEL_X86
+        switch (rs_simd_get_level()) {
+        case RS_SIMD_AVX512:
+                return rs_panel_kernels_avx512[rolling][order][extrema];
+        case RS_SIMD_AVX2:
+                return rs_panel_kernels_avx2[rolling][order][extrema];
+        default:
+                break;
+        }
+#endif
+        return rs_panel_kernels_base[rolling][order][extrema];
+}
+
+/* with a measuring arena (base NULL) only sizes the block */
+static rs_panel *rs_panel_place(rs_arena *a, size_t n_series, size_t window,
+                                unsigned int stats) {
+        rs_panel *p = rs_arena_take(a, sizeof(rs_panel));
+        size_t bytes = n_series * sizeof(double);
+        int order = rs_stats_order(stats);
+        bool extrema = rs_stats_extrema(stats);
+        rs_panel layout = {0};
+
+        if (extrema) {
+                layout.mins = rs_arena_take(a, bytes);
+                layout.maxs = rs_arena_take(a, bytes);
+        }
+        if (order >= 1) {
+                layout.sums = rs_arena_take(a, bytes);
+                layout.means = rs_arena_take(a, bytes);
+        }
+        if (order >= 2)
+                layout.M2 = rs_arena_take(a, bytes);
+        if (order >= 3)
+                layout.M3 = rs_arena_take(a, bytes);
+        if (order >= 4)
+                layout.M4 = rs_arena_take(a, bytes);
+        if (window > 0) {
+                layout.ring = rs_arena_take(a, window * bytes);
+                if (extrema) {
+                        size_t n = n_series * sizeof(monotonic_deque *);
+                        layout.min_deques = rs_arena_take(a, n);
+                        layout.max_deques = rs_arena_take(a, n);
+                        for (size_t i = 0; i < n_series; i++) {
+                                monotonic_deque *lo =
+                                    monotonic_deque_place(a, window, true);
+                                monotonic_deque *hi =
+                                    monotonic_deque_place(a, window, false);
+                                if (p) {
+                                        layout.min_deques[i] = lo;
+                                        layout.max_deques[i] = hi;
+                                }
+                        }
+                }
+        }
+        if (p)
+                *p = layout;
+        return p;
+}
+
+rs_panel *rs_panel_alloc(size_t n_series, size_t window, unsigned int stats) {
+        if (n_series == 0 || !(stats & RS_STAT_ALL)) {
+                fprintf(stderr,
+                        "[rs_panel_alloc] no series or statistics selected\n");
+                return NULL;
+        }
+        rs_arena a = {NULL, 0, 0};
+
+        stats &= RS_STAT_ALL;
+        rs_panel_place(&a, n_series, window, stats);
+        a.size = a.used;
+        a.used = 0;
+        a.base = rs_allocator_aligned.alloc(NULL, a.size);
+        if (!a.base) {
+                fprintf(stderr, "[rs_panel_alloc] malloc error\n");
+                return NULL;
+        }
+        rs_panel *p = rs_panel_place(&a, n_series, window, stats);
+        p->n_series = n_series;
+        p->window = window;
+        p->stats = stats;
+        p->arena = a.base;
+        rs_panel_reset(p);
+        return p;
+}
+
+void rs_panel_free(rs_panel *p) {
+        if (p) {
+                /* everything, p included, lives in the block */
+                rs_allocator_aligned.release(NULL, p->arena, 0);
+        }
+}
+
+void rs_panel_reset(rs_panel *p) {
+        size_t bytes = p->n_series * sizeof(double);
+        double *arrays[] = {p->mins, p->maxs, p->sums, p->means,
+                            p->M2,   p->M3,   p->M4};
+
+        p->count = 0;
+        p->seq = 0;
+        p->pos = 0;
+        for (size_t k = 0; k < sizeof(arrays) / sizeof(arrays[0]); k++) {
+                if (arrays[k])
+                        memset(arrays[k], 0, bytes);
+        }
+        for (size_t i = 0; p->min_deques && i < p->n_series; i++) {
+                monotonic_deque_reset(p->min_deques[i]);
+                monotonic_deque_reset(p->max_deques[i]);
+        }
+}
+
+void rs_panel_update_row(rs_panel *p, const double *row) {
+        rs_panel_kernel_get(p)(p, row, 1);
+}
+
+void rs_panel_update_rows(rs_panel *p, const double *rows, size_t n_rows) {
+        rs_panel_kernel_get(p)(p, rows, n_rows);
+}
+
+int rs_panel_column(rs_panel *p, unsigned int stat, double *out) {
+        if (!(p->stats & stat) || (stat & (stat - 1))) {
+                fprintf(stderr,
+                        "[rs_panel_column] statistic not computed by this "
+                        "panel\n");
+                return -1;
+        }
+        size_t n_series = p->n_series;
+        double n = (double)p->count;
+        rs_moments m = {0};
+
+        for (size_t i = 0; i < n_series; i++) {
+                m.M2 = p->M2 ? p->M2[i] : 0.0;
+                m.M3 = p->M3 ? p->M3[i] : 0.0;
+                m.M4 = p->M4 ? p->M4[i] : 0.0;
+                switch (stat) {
+                case RS_STAT_SUM:
+                        out[i] = p->sums[i];
+                        break;
+                case RS_STAT_MIN:
+                        out[i] = p->mins[i];
+                        break;
+                case RS_STAT_MAX:
+                        out[i] = p->maxs[i];
+                        break;
+                case RS_STAT_MEAN:
+                        out[i] = p->means[i];
+                        break;
+                case RS_STAT_VARIANCE:
+                        out[i] = rs_moments_variance(&m, n);
+                        break;
+                case RS_STAT_STDDEV:
+                        out[i] = sqrt(rs_moments_variance(&m, n));
+                        break;
+                case RS_STAT_SKEW:
+                        out[i] = rs_moments_skewness(&m, n);
+                        break;
+                default:
+                        out[i] = rs_moments_kurtosis(&m, n);
+                        break;
+                }
+        }
+        return 0;
+}
+
+/* series i as a whole-sample summary, zero where not computed */
+void rs_panel_get(rs_panel *p, size_t series, rs_stats *out) {
+        rs_stats_reset(out);
+        out->count = p->count;
+        if (p->mins) {
+                out->min = p->mins[series];
+                out->max = p->maxs[series];
+        }
+        if (p->sums) {
+                out->sum = p->sums[series];
+                out->mean = p->means[series];
+        }
+        out->M2 = p->M2 ? p->M2[series] : 0.0;
+        out->M3 = p->M3 ? p->M3[series] : 0.0;
+        out->M4 = p->M4 ? p->M4[series] : 0.0;
+}
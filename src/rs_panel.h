@@ -0,0 +1,46 @@
+#ifndef __RS_PANEL_H_
+#define __RS_PANEL_H_
+
+#include "rs_rolling.h"
+
+/*
+running stats of n_series series sharing one time axis, stored as structure
+of arrays: each moment is a contiguous array across the series, so a row of
+n_series new values updates every accumulator in one vectorised sweep. the
+count, and so 1/n, is shared by all series. with a window the panel keeps
+the last window rows in a strided ring (row-major, n_series wide) and pops
+the oldest row as each new one arrives; window 0 accumulates everything.
+*/
+
+typedef struct rs_panel {
+        size_t n_series;
+        size_t window;
+        size_t count;
+        size_t seq;
+        size_t pos;
+        unsigned int stats;
+        double *mins;
+        double *maxs;
+        double *sums;
+        double *means;
+        double *M2;
+        double *M3;
+        double *M4;
+        double *ring;
+        monotonic_deque **min_deques;
+        monotonic_deque **max_deques;
+        void *arena;
+} rs_panel;
+
+rs_panel *rs_panel_alloc(size_t n_series, size_t window, unsigned int stats);
+void rs_panel_free(rs_panel *p);
+void rs_panel_reset(rs_panel *p);
+/* row holds one value per series */
+void rs_panel_update_row(rs_panel *p, const double *row);
+/* n_rows rows back to back, row-major */
+void rs_panel_update_rows(rs_panel *p, const double *rows, size_t n_rows);
+/* one RS_STAT_* statistic for every series into out[n_series] */
+int rs_panel_column(rs_panel *p, unsigned int stat, double *out);
+void rs_panel_get(rs_panel *p, size_t series, rs_stats *out);
+
+#endif
@@ -0,0 +1,135 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "rs_parallel.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <unistd.h>
+#include "rs_simd.h"
+
+typedef struct rs_parallel_chunk {
+        const double *data;
+        size_t length;
+        rs_stats stats;
+} rs_parallel_chunk;
+
+size_t rs_parallel_threads(size_t n_threads) {
+        if (n_threads == 0) {
+                long n_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+                n_threads = n_cpus > 0 ? (size_t)n_cpus : 1;
+        }
+        return n_threads;
+}
+
+typedef struct rs_parallel_task {
+        rs_parallel_fn fn;
+        void *arg;
+        size_t index;
+} rs_parallel_task;
+
+static void *rs_parallel_task_run(void *arg) {
+        rs_parallel_task *task = arg;
+        task->fn(task->arg, task->index);
+        return NULL;
+}
+
+int rs_parallel_for(size_t n_tasks, rs_parallel_fn fn, void *arg) {
+        if (n_tasks <= 1) {
+                if (n_tasks == 1)
+                        fn(arg, 0);
+                return 0;
+        }
+
+        rs_parallel_task *tasks = malloc(n_tasks * sizeof(*tasks));
+        pthread_t *threads = malloc(n_tasks * sizeof(*threads));
+        bool *started = calloc(n_tasks, sizeof(*started));
+        if (!tasks || !threads || !started) {
+                fprintf(stderr, "[rs_parallel_for] malloc error\n");
+                free(tasks);
+                free(threads);
+                free(started);
+                return -1;
+        }
+
+        /* task 0 runs on the calling thread, a failed create runs inline */
+        for (size_t t = 0; t < n_tasks; t++) {
+                tasks[t].fn = fn;
+                tasks[t].arg = arg;
+                tasks[t].index = t;
+        }
+        for (size_t t = 1; t < n_tasks; t++) {
+                started[t] = pthread_create(&threads[t], NULL,
+                                            rs_parallel_task_run,
+                                            &tasks[t]) == 0;
+        }
+        fn(arg, 0);
+        for (size_t t = 1; t < n_tasks; t++) {
+                if (started[t])
+                        pthread_join(threads[t], NULL);
+                else
+                        fn(arg, t);
+        }
+        free(tasks);
+        free(threads);
+        free(started);
+        return 0;
+}
+
+static void rs_parallel_stats_task(void *arg, size_t index) {
+        rs_parallel_chunk *chunk = (rs_parallel_chunk *)arg + index;
+        rs_simd_stats(chunk->data, chunk->length, &chunk->stats);
+}
+
+int rs_parallel_stats(const double *data, size_t length, size_t n_threads,
+                      rs_stats *out) {
+        size_t n_blocks = (length + RS_SIMD_BLOCK - 1) / RS_SIMD_BLOCK;
+
+        n_threads = rs_parallel_threads(n_threads);
+        if (n_threads > n_blocks) {
+                n_threads = n_blocks;
+        }
+        if (n_threads <= 1) {
+                rs_simd_stats(data, length, out);
+                return 0;
+        }
+
+        rs_parallel_chunk *chunks = malloc(n_threads * sizeof(*chunks));
+        if (!chunks) {
+                fprintf(stderr, "[rs_parallel_stats] malloc error\n");
+                return -1;
+        }
+
+        /* even split of whole blocks, as rs_rolling_roll_parallel splits
+           rows: with n_threads <= n_blocks every thread gets at least one */
+        for (size_t t = 0; t < n_threads; t++) {
+                size_t first = t * n_blocks / n_threads * RS_SIMD_BLOCK;
+                size_t last = (t + 1) * n_blocks / n_threads * RS_SIMD_BLOCK;
+                if (last > length)
+                        last = length;
+                chunks[t].data = data + first;
+                chunks[t].length = last - first;
+        }
+        if (rs_parallel_for(n_threads, rs_parallel_stats_task, chunks) != 0) {
+                free(chunks);
+                return -1;
+        }
+
+        rs_stats_reset(out);
+        for (size_t t = 0; t < n_threads; t++) {
+                rs_stats_combine(out, &chunks[t].stats);
+        }
+        free(chunks);
+        return 0;
+}
+
+int rs_vector_calculate_parallel(rs_vector *v, size_t n_threads) {
+        rs_stats s;
+
+        if (!rs_vector_check_data("rs_vector_calculate_parallel", v))
+                return -1;
+        int rc = rs_parallel_stats(v->data, v->count, n_threads, &s);
+
+        if (rc == 0) {
+                rs_vector_set_stats(v, &s);
+        }
+        return rc;
+}
@@ -0,0 +1,23 @@
+#ifndef __RS_PARALLEL_H_
+#define __RS_PARALLEL_H_
+
+#include "rs_vector.h"
+#include "rs_moments.h"
+
+/*
+multithreaded reductions. the input is split into one contiguous chunk per
+thread (chunk boundaries fall on RS_SIMD_BLOCK multiples) and the per-thread
+summaries are merged in chunk order, so for a fixed thread count the result
+is deterministic. n_threads == 0 uses every online cpu.
+*/
+
+typedef void (*rs_parallel_fn)(void *arg, size_t index);
+
+size_t rs_parallel_threads(size_t n_threads);
+/* runs fn(arg, i) for i in [0, n_tasks), one thread per task, and joins */
+int rs_parallel_for(size_t n_tasks, rs_parallel_fn fn, void *arg);
+int rs_parallel_stats(const double *data, size_t length, size_t n_threads,
+                      rs_stats *out);
+int rs_vector_calculate_parallel(rs_vector *v, size_t n_threads);
+
+#endif
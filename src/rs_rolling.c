@@ -1,27 +1,162 @@
 #include "rs_rolling.h"
+#include "rs_instr.h"
+#include "rs_parallel.h"
 
-rs_rolling *rs_rolling_alloc(rs_vector *v, size_t window) {
+static RS_ALWAYS_INLINE void rs_rolling_emit(rs_rolling *r, circular_array *ca,
+                                             const rs_moments *m, double n,
+                                             size_t out) {
+        if (r->sums)
+                r->sums->data[out] = rs_moments_sum(m);
+        if (r->mins)
+                r->mins->data[out] = monotonic_deque_front(ca->min_deque);
+        if (r->maxs)
+                r->maxs->data[out] = monotonic_deque_front(ca->max_deque);
+        if (r->means)
+                r->means->data[out] = rs_moments_mean(m);
+        if (r->variances || r->stddevs) {
+                double variance = rs_moments_variance(m, n);
+                if (r->variances)
+                        r->variances->data[out] = variance;
+                if (r->stddevs)
+                        r->stddevs->data[out] = sqrt(variance);
+        }
+        if (r->skews)
+                r->skews->data[out] = rs_moments_skewness(m, n);
+        if (r->kurts)
+                r->kurts->data[out] = rs_moments_kurtosis(m, n);
+}
+
+/* fills output slots [first, last), slot j covering src[j, j + window).
+   order, extrema and accurate are constants in every instantiation below,
+   so the unused moment updates, deque maintenance and compensation are
+   compiled out. in accurate mode sum/mean are Neumaier-compensated and the
+   moments are recomputed from the window every reanchor_interval steps */
+static RS_ALWAYS_INLINE void
+rs_rolling_kernel_body(rs_rolling *r, circular_array *ca, const double *src,
+                       size_t first, size_t last, const int order,
+                       const bool extrema, const bool accurate) {
+        if (first >= last) {
+                return;
+        }
+        size_t window = r->window;
+        size_t since_anchor = 0;
+        rs_moments m;
+
+        circular_array_reset(ca);
+        m = ca->moments;
+        for (size_t i = first; i < first + window; i++) {
+                double item = src[i];
+                ca->data[ca->count++] = item;
+                rs_moments_put(&m, item, (double)ca->count, order, accurate);
+                if (extrema) {
+                        monotonic_deque_push(ca->min_deque, item, ca->seq);
+                        monotonic_deque_push(ca->max_deque, item, ca->seq);
+                }
+                ca->seq++;
+        }
+
+        double n = (double)window;
+        size_t pos = 0;
+        rs_rolling_emit(r, ca, &m, n, first);
+
+        // now roll baby, roll
+        for (size_t j = first + 1; j < last; j++) {
+                double item = src[j + window - 1];
+                double evicted = ca->data[pos];
+                ca->data[pos] = item;
+                if (++pos == window)
+                        pos = 0;
+                rs_moments_pop(&m, evicted, n - 1.0, order, accurate);
+                rs_moments_put(&m, item, n, order, accurate);
+                if (accurate && ++since_anchor == r->reanchor_interval) {
+                        since_anchor = 0;
+                        ca->head = pos;
+                        ca->tail = pos;
+                        circular_array_reanchor(ca);
+                        m = ca->moments;
+                }
+                if (extrema) {
+                        monotonic_deque_evict(ca->min_deque, ca->seq - window);
+                        monotonic_deque_evict(ca->max_deque, ca->seq - window);
+                        monotonic_deque_push(ca->min_deque, item, ca->seq);
+                        monotonic_deque_push(ca->max_deque, item, ca->seq);
+                }
+                ca->seq++;
+                rs_rolling_emit(r, ca, &m, n, j);
+        }
+        ca->head = pos;
+        ca->tail = pos;
+        ca->moments = m;
+}
+
+#define RS_ROLLING_KERNEL_DEFINE(order, extrema)                               \
+        static void rs_rolling_kernel_##order##_##extrema##_0(                 \
+            rs_rolling *r, circular_array *ca, const double *src,              \
+            size_t first, size_t last) {                                       \
+                rs_rolling_kernel_body(r, ca, src, first, last, order,         \
+                                       extrema, false);                        \
+        }                                                                      \
+        static void rs_rolling_kernel_##order##_##extrema##_1(                 \
+            rs_rolling *r, circular_array *ca, const double *src,              \
+            size_t first, size_t last) {                                       \
+                rs_rolling_kernel_body(r, ca, src, first, last, order,         \
+                                       extrema, true);                         \
+        }
+
+#define RS_ROLLING_KERNEL_ENTRY(order, extrema)                                \
+        [order][extrema][0] = rs_rolling_kernel_##order##_##extrema##_0,       \
+        [order][extrema][1] = rs_rolling_kernel_##order##_##extrema##_1,
+
+RS_ROLLING_KERNELS(RS_ROLLING_KERNEL_DEFINE)
+
+static const rs_rolling_kernel rs_rolling_kernels[5][2][2] = {
+        RS_ROLLING_KERNELS(RS_ROLLING_KERNEL_ENTRY)
+};
+
+static void rs_rolling_select_kernel(rs_rolling *r) {
+        r->kernel = rs_rolling_kernels[rs_stats_order(r->stats)]
+                                      [rs_stats_extrema(r->stats)]
+                                      [r->reanchor_interval > 0];
+}
+
+rs_rolling *rs_rolling_alloc(rs_vector *v, size_t window, unsigned int stats) {
+        if (!(stats & RS_STAT_ALL)) {
+                fprintf(stderr, "[rs_rolling_alloc] no statistics selected\n");
+                return NULL;
+        }
+        if (window < 1) {
+                fprintf(stderr, "[rs_rolling_alloc] window must be > 0\n");
+                return NULL;
+        }
+        if (!rs_vector_check_data("rs_rolling_alloc", v))
+                return NULL;
         rs_rolling *r = malloc(sizeof(rs_rolling));
         if (!r) {
                 fprintf(stderr, "[rs_rolling_alloc] malloc error\n");
                 return NULL;
         } else {
-                size_t size = v->count - window;
+                size_t size = rs_rolling_output_size(v->count, 0, window);
+                bool failed = false;
+
                 r->source_data = v;
                 r->window = window;
-                r->window_data = circular_array_alloc(window);
-                r->mins = rs_vector_alloc(size);
-                r->maxs = rs_vector_alloc(size);
-                r->sums = rs_vector_alloc(size);
-                r->means = rs_vector_alloc(size);
-                r->variances = rs_vector_alloc(size);
-                r->stddevs = rs_vector_alloc(size);
-                r->skews = rs_vector_alloc(size);
-                r->kurts = rs_vector_alloc(size);
-
-                if (!r->window_data || !r->mins || !r->maxs || !r->sums ||
-                    !r->means || !r->variances || !r->stddevs || !r->skews ||
-                    !r->kurts) {
+                r->count = 0;
+                r->stats = stats & RS_STAT_ALL;
+                r->reanchor_interval = 0;
+                r->arena = NULL;
+                r->n_quantiles = 0;
+                r->order_stats = NULL;
+                rs_rolling_select_kernel(r);
+                r->window_data =
+                    circular_array_alloc(window, rs_stats_extrema(r->stats));
+                failed |= !r->window_data;
+#define X(flag, member, name)                                                  \
+        r->member = (r->stats & flag) ? rs_vector_alloc(size) : NULL;          \
+        failed |= (r->stats & flag) && !r->member;
+                RS_ROLLING_SERIES(X)
+#undef X
+
+                if (failed) {
                         fprintf(stderr, "[rs_rolling_alloc] malloc error\n");
                         exit(1);
                 }
@@ -29,60 +164,367 @@ rs_rolling *rs_rolling_alloc(rs_vector *v, size_t window) {
         return r;
 }
 
-void rs_rolling_roll(rs_rolling *r, size_t start_index) {
+/* with a measuring arena (base NULL) only sizes the block */
+static rs_rolling *rs_rolling_place(rs_arena *a, size_t window,
+                                    unsigned int stats, size_t rows) {
+        rs_rolling *r = rs_arena_take(a, sizeof(rs_rolling));
+        circular_array *ca =
+            circular_array_place(a, window, rs_stats_extrema(stats));
+
+        if (r)
+                r->window_data = ca;
+#define X(flag, member, name)                                                  \
+        {                                                                      \
+                rs_vector *series =                                            \
+                    (stats & flag) ? rs_vector_place(a, rows) : NULL;          \
+                if (r)                                                         \
+                        r->member = series;                                    \
+        }
+        RS_ROLLING_SERIES(X)
+#undef X
+        return r;
+}
+
+rs_rolling *rs_rolling_alloc_arena(rs_vector *v, size_t window,
+                                   unsigned int stats, size_t max_rows) {
+        if (!(stats & RS_STAT_ALL)) {
+                fprintf(stderr,
+                        "[rs_rolling_alloc_arena] no statistics selected\n");
+                return NULL;
+        }
+        if (window < 1) {
+                fprintf(stderr,
+                        "[rs_rolling_alloc_arena] window must be > 0\n");
+                return NULL;
+        }
+        if (!rs_vector_check_data("rs_rolling_alloc_arena", v))
+                return NULL;
+        size_t rows = rs_rolling_output_size(v->count, 0, window);
+        rs_arena a = {NULL, 0, 0};
+
+        if (max_rows > rows)
+                rows = max_rows;
+        stats &= RS_STAT_ALL;
+        rs_rolling_place(&a, window, stats, rows);
+        a.size = a.used;
+        a.used = 0;
+        a.base = rs_allocator_aligned.alloc(NULL, a.size);
+        if (!a.base) {
+                fprintf(stderr, "[rs_rolling_alloc_arena] malloc error\n");
+                return NULL;
+        }
+        rs_rolling *r = rs_rolling_place(&a, window, stats, rows);
+        r->source_data = v;
+        r->window = window;
+        r->count = 0;
+        r->stats = stats;
+        r->reanchor_interval = 0;
+        r->arena = a.base;
+        r->n_quantiles = 0;
+        r->order_stats = NULL;
+        rs_rolling_select_kernel(r);
+        return r;
+}
+
+static int rs_rolling_reserve(rs_rolling *r, size_t size) {
+        int rc = 0;
+
+#define X(flag, member, name)                                                  \
+        if (r->member)                                                         \
+                rc |= rs_vector_reserve(r->member, size);
+        RS_ROLLING_SERIES(X)
+#undef X
+        for (size_t q = 0; q < r->n_quantiles; q++)
+                rc |= rs_vector_reserve(r->quantiles[q], size);
+        return rc;
+}
+
+static void rs_rolling_set_count(rs_rolling *r, size_t count) {
+#define X(flag, member, name)                                                  \
+        if (r->member)                                                         \
+                r->member->count = count;
+        RS_ROLLING_SERIES(X)
+#undef X
+        for (size_t q = 0; q < r->n_quantiles; q++)
+                r->quantiles[q]->count = count;
+        r->count = count;
+}
+
+/* output j covers src[j, j + window), as in the moment kernels. the first
+   skiplist failure (a NaN entering the window) fills the rows from there on
+   with NAN and stops, rather than reading a list that no longer matches
+   the window */
+static int rs_rolling_quantile_body(rs_rolling *r, rs_skiplist *s,
+                                    const double *src, size_t first,
+                                    size_t last) {
+        size_t out = first;
+        int rc = 0;
+
+        rs_skiplist_reset(s);
+        if (first >= last)
+                return 0;
+        for (size_t i = first; rc == 0 && i < first + r->window - 1; i++)
+                rc = rs_skiplist_insert(s, src[i]);
+        for (; rc == 0 && out < last; out++) {
+                if (rs_skiplist_insert(s, src[out + r->window - 1]) != 0)
+                        break;
+                for (size_t q = 0; q < r->n_quantiles; q++)
+                        r->quantiles[q]->data[out] = rs_skiplist_quantile(
+                            s, r->quantile_levels[q]);
+                rc = rs_skiplist_remove(s, src[out]);
+        }
+        if (out == last && rc == 0)
+                return 0;
+        fprintf(stderr, "[rs_rolling_roll] quantiles stop at row %zu\n", out);
+        for (; out < last; out++) {
+                for (size_t q = 0; q < r->n_quantiles; q++)
+                        r->quantiles[q]->data[out] = NAN;
+        }
+        return -1;
+}
+
+static void rs_rolling_drop_quantiles(rs_rolling *r) {
+        for (size_t q = 0; q < r->n_quantiles; q++)
+                rs_vector_free(r->quantiles[q]);
+        rs_skiplist_free(r->order_stats);
+        r->order_stats = NULL;
+        r->n_quantiles = 0;
+}
+
+int rs_rolling_set_quantiles(rs_rolling *r, const double *levels, size_t n) {
+        if (!r)
+                return -1;
+        if (n > RS_ROLLING_MAX_QUANTILES) {
+                fprintf(stderr,
+                        "[rs_rolling_set_quantiles] at most %d quantiles\n",
+                        RS_ROLLING_MAX_QUANTILES);
+                return -1;
+        }
+        for (size_t q = 0; q < n; q++) {
+                if (!(levels[q] >= 0.0 && levels[q] <= 1.0)) {
+                        fprintf(stderr, "[rs_rolling_set_quantiles] levels "
+                                        "must be in [0, 1]\n");
+                        return -1;
+                }
+        }
+        rs_rolling_drop_quantiles(r);
+        if (n == 0)
+                return 0;
+
+        size_t size = rs_rolling_output_size(r->source_data->count, 0,
+                                             r->window);
+        r->order_stats = rs_skiplist_alloc(r->window);
+        if (!r->order_stats)
+                return -1;
+        for (size_t q = 0; q < n; q++) {
+                r->quantiles[q] = rs_vector_alloc(size);
+                if (!r->quantiles[q]) {
+                        fprintf(stderr,
+                                "[rs_rolling_set_quantiles] malloc error\n");
+                        rs_rolling_drop_quantiles(r);
+                        return -1;
+                }
+                r->n_quantiles = q + 1;
+                r->quantile_levels[q] = levels[q];
+                snprintf(r->quantile_names[q], RS_ROLLING_QUANTILE_NAME,
+                         "Q%g", levels[q]);
+        }
+        return 0;
+}
+
+/* accuracy mode: compensated sum/mean plus a re-anchor of the moments from
+   the window contents every reanchor_interval steps (0 means every window
+   length steps, keeping the amortised cost O(1) per step) */
+void rs_rolling_set_accuracy(rs_rolling *r, bool accurate,
+                             size_t reanchor_interval) {
+        if (r) {
+                if (accurate && reanchor_interval == 0)
+                        reanchor_interval = r->window;
+                r->reanchor_interval = accurate ? reanchor_interval : 0;
+                rs_rolling_select_kernel(r);
+        }
+}
+
+/* output series are written in place, their own running stats are left
+   untouched until rs_rolling_calculate is called. -1 when the rows cannot
+   be reserved, r left as it was, or when the quantile pass stops; the rows
+   are then written and NAN from the failure on */
+int rs_rolling_roll(rs_rolling *r, size_t start_index) {
+        int rc = -1;
 
         if (r) {
-                
-                for (size_t i = start_index; i < (start_index + r->window); i++) {
-                        circular_array_put(r->window_data, rs_vector_get(r->source_data, i));
+                size_t size = rs_rolling_output_size(r->source_data->count,
+                                                     start_index, r->window);
+                if (rs_rolling_reserve(r, size) != 0) {
+                        fprintf(stderr,
+                                "[rs_rolling_roll] cannot reserve %zu rows\n",
+                                size);
+                        return -1;
                 }
+                rc = 0;
+                RS_INSTR_TIME_BEGIN(t0);
+                r->kernel(r, r->window_data,
+                          r->source_data->data + start_index, 0, size);
+                if (r->n_quantiles)
+                        rc = rs_rolling_quantile_body(
+                            r, r->order_stats,
+                            r->source_data->data + start_index, 0, size);
+                RS_INSTR_TIME_END(t0, roll_ticks);
+                RS_INSTR_ADD(rolls, 1);
+                RS_INSTR_ADD(roll_windows, size);
+                RS_INSTR_ADD(evictions, size > 0 ? size - 1 : 0);
+                rs_rolling_set_count(r, size);
+        }
+        return rc;
+}
 
-                rs_vector_item_push(r->sums, circular_array_sum(r->window_data));
-                rs_vector_item_push(r->mins, circular_array_min(r->window_data));
-                rs_vector_item_push(r->maxs, circular_array_max(r->window_data));
-                rs_vector_item_push(r->means, circular_array_mean(r->window_data));
-                rs_vector_item_push(r->variances, circular_array_variance(r->window_data));
-                rs_vector_item_push(r->stddevs, circular_array_stddev(r->window_data));
-                rs_vector_item_push(r->skews, circular_array_skewness(r->window_data));
-                rs_vector_item_push(r->kurts, circular_array_kurtosis(r->window_data));
-                r->count = r->sums->count;
+typedef struct rs_rolling_slice {
+        rs_rolling *r;
+        const double *src;
+        size_t size;
+        size_t n_slices;
+        circular_array **windows;
+        rs_skiplist **order_stats;
+        int quantile_rc;
+} rs_rolling_slice;
 
+static void rs_rolling_slice_task(void *arg, size_t index) {
+        rs_rolling_slice *s = arg;
+        /* even split: with n_slices <= size / window every slice holds at
+           least a window of rows, the last one included */
+        size_t first = index * s->size / s->n_slices;
+        size_t last = (index + 1) * s->size / s->n_slices;
 
-                // now roll baby, roll
-                size_t count = r->source_data->count;
+        RS_INSTR_TIME_BEGIN(t0);
+        s->r->kernel(s->r, s->windows[index], s->src, first, last);
+        if (s->r->n_quantiles &&
+            rs_rolling_quantile_body(s->r, s->order_stats[index], s->src,
+                                     first, last) != 0)
+                __atomic_store_n(&s->quantile_rc, -1, __ATOMIC_RELAXED);
+        RS_INSTR_TIME_END(t0, roll_ticks);
+        /* counted on the worker, each slice starts from a fresh window */
+        RS_INSTR_ADD(roll_windows, last - first);
+        RS_INSTR_ADD(evictions, last > first ? last - first - 1 : 0);
+}
 
-                double tmp = 0.0;
+/* each thread seeds its own circular_array with the window - 1 samples
+   preceding its slice and writes the slice in place. the extrema are
+   identical to rs_rolling_roll; the moments of each slice start from a
+   fresh window rather than inheriting the add/remove history of the
+   preceding slices, so they agree with the sequential roll to within the
+   drift that history accumulates (relative differences of order 1e-12
+   on well conditioned data). the last slice runs on r->window_data,
+   leaving it in the same state as a sequential roll */
+int rs_rolling_roll_parallel(rs_rolling *r, size_t start_index,
+                             size_t n_threads) {
+        int rc = -1;
 
-                for (size_t i = (start_index + r->window); i < count; i++) {
-                        circular_array_get(r->window_data, &tmp);
-                        circular_array_put(r->window_data, rs_vector_get(r->source_data, i));
+        if (r) {
+                size_t size = rs_rolling_output_size(r->source_data->count,
+                                                     start_index, r->window);
+                size_t n_slices = rs_parallel_threads(n_threads);
 
-                        rs_vector_item_push(r->sums, circular_array_sum(r->window_data));
-                        rs_vector_item_push(r->mins, circular_array_min(r->window_data));
-                        rs_vector_item_push(r->maxs, circular_array_max(r->window_data));
-                        rs_vector_item_push(r->means, circular_array_mean(r->window_data));;
-                        rs_vector_item_push(r->variances, circular_array_variance(r->window_data));
-                        rs_vector_item_push(r->stddevs, circular_array_stddev(r->window_data));
-                        rs_vector_item_push(r->skews, circular_array_skewness(r->window_data));
-                        rs_vector_item_push(r->kurts, circular_array_kurtosis(r->window_data));
-                        r->count = r->sums->count;
+                /* keep every slice at least a window long */
+                if (n_slices > size / r->window)
+                        n_slices = size / r->window;
+                if (n_slices <= 1)
+                        return rs_rolling_roll(r, start_index);
+                if (rs_rolling_reserve(r, size) != 0) {
+                        fprintf(stderr,
+                                "[rs_rolling_roll_parallel] cannot reserve %zu "
+                                "rows\n",
+                                size);
+                        return -1;
                 }
+
+                circular_array **windows = calloc(n_slices, sizeof(*windows));
+                rs_skiplist **order_stats =
+                    calloc(n_slices, sizeof(*order_stats));
+                bool failed = !windows || !order_stats;
+                for (size_t t = 0; !failed && t < n_slices - 1; t++) {
+                        windows[t] = circular_array_alloc(
+                            r->window, rs_stats_extrema(r->stats));
+                        failed |= !windows[t];
+                        if (r->n_quantiles) {
+                                order_stats[t] = rs_skiplist_alloc(r->window);
+                                failed |= !order_stats[t];
+                        }
+                }
+                if (!failed) {
+                        windows[n_slices - 1] = r->window_data;
+                        order_stats[n_slices - 1] = r->order_stats;
+                        rs_rolling_slice s = {r,
+                                              r->source_data->data +
+                                                  start_index,
+                                              size, n_slices, windows,
+                                              order_stats, 0};
+                        rc = rs_parallel_for(n_slices, rs_rolling_slice_task,
+                                             &s);
+                        if (rc == 0) {
+                                RS_INSTR_ADD(rolls, 1);
+                                rs_rolling_set_count(r, size);
+                                /* the rows are written, NAN past a failure */
+                                rc = s.quantile_rc;
+                        }
+                } else {
+                        fprintf(stderr,
+                                "[rs_rolling_roll_parallel] malloc error\n");
+                }
+                for (size_t t = 0; windows && t < n_slices - 1; t++) {
+                        circular_array_free(windows[t]);
+                }
+                for (size_t t = 0; order_stats && t < n_slices - 1; t++) {
+                        rs_skiplist_free(order_stats[t]);
+                }
+                free(windows);
+                free(order_stats);
+        }
+        return rc;
+}
+
+/* stats of the stats, only computed on request */
+void rs_rolling_calculate(rs_rolling *r) {
+        if (r) {
+#define X(flag, member, name)                                                  \
+        if (r->member)                                                         \
+                rs_vector_calculate(r->member);
+                RS_ROLLING_SERIES(X)
+#undef X
+                for (size_t q = 0; q < r->n_quantiles; q++)
+                        rs_vector_calculate(r->quantiles[q]);
         }
 }
 
+/* a stats-only source is refused and r left as it was */
+int rs_rolling_reset(rs_rolling *r, rs_vector *v) {
+        if (r) {
+                if (v && !rs_vector_check_data("rs_rolling_reset", v))
+                        return -1;
+                if (v)
+                        r->source_data = v;
+                circular_array_reset(r->window_data);
+                rs_rolling_set_count(r, 0);
+        }
+        return 0;
+}
+
 void rs_rolling_free(rs_rolling *r) {
+        if (r)
+                rs_rolling_drop_quantiles(r);
+        if (r && r->arena) {
+                /* everything, r included, lives in the block */
+                rs_allocator_aligned.release(NULL, r->arena, 0);
+                return;
+        }
         if (r) {
                 if (r->window_data) {
                         circular_array_free(r->window_data);
                 }
-                if (r->mins) rs_vector_free(r->mins);
-                if (r->maxs) rs_vector_free(r->maxs);
-                if (r->sums) rs_vector_free(r->sums);
-                if (r->means) rs_vector_free(r->means);
-                if (r->variances) rs_vector_free(r->variances);
-                if (r->stddevs) rs_vector_free(r->stddevs);
-                if (r->skews) rs_vector_free(r->skews);
-                if (r->kurts) rs_vector_free(r->kurts);
+#define X(flag, member, name)                                                  \
+        if (r->member)                                                         \
+                rs_vector_free(r->member);
+                RS_ROLLING_SERIES(X)
+#undef X
                 // if (r->v) rs_vector_free(r->v);
                 free(r);
                 r = NULL;
@@ -91,17 +533,39 @@ void rs_rolling_free(rs_rolling *r) {
 
 void rs_rolling_print(rs_rolling *r) {
         if (r) {
-                fprintf(stdout, "Sum;Mean;Variance;Stddev;Skew;Kurt\n");
+#define X(flag, member, name) r->member,
+                rs_vector *cols[8 + RS_ROLLING_MAX_QUANTILES] = {
+                    RS_ROLLING_SERIES(X)};
+#undef X
+#define X(flag, member, name) name,
+                const char *names[8 + RS_ROLLING_MAX_QUANTILES] = {
+                    RS_ROLLING_SERIES(X)};
+#undef X
+                size_t n_cols = 8;
+                const char *sep = "";
+
+                for (size_t q = 0; q < r->n_quantiles; q++) {
+                        cols[n_cols] = r->quantiles[q];
+                        names[n_cols++] = r->quantile_names[q];
+                }
+                for (size_t c = 0; c < n_cols; c++) {
+                        if (cols[c]) {
+                                fprintf(stdout, "%s%s", sep, names[c]);
+                                sep = ";";
+                        }
+                }
+                fprintf(stdout, "\n");
 
                 for (size_t i = 0; i < r->count; i++) {
-                        fprintf(stdout,
-                                "%.6f;%.6f;%.6f;%.6f;%.6f;%.6f\n",
-                                rs_vector_get(r->sums, i),
-                                rs_vector_get(r->means, i),
-                                rs_vector_get(r->variances, i),
-                                rs_vector_get(r->stddevs, i),
-                                rs_vector_get(r->skews, i),
-                                rs_vector_get(r->kurts, i));
+                        sep = "";
+                        for (size_t c = 0; c < n_cols; c++) {
+                                if (cols[c]) {
+                                        fprintf(stdout, "%s%.6f", sep,
+                                                cols[c]->data[i]);
+                                        sep = ";";
+                                }
+                        }
+                        fprintf(stdout, "\n");
                 }
         }
 }
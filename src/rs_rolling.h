@@ -1,13 +1,57 @@
 #ifndef __RS_ROLLING_H_
 #define __RS_ROLLING_H_
 
+#include "rs_skiplist.h"
 #include "rs_vector.h"
 
+/* statistic selection flags for rs_rolling_alloc */
+#define RS_STAT_SUM (1u << 0)
+#define RS_STAT_MIN (1u << 1)
+#define RS_STAT_MAX (1u << 2)
+#define RS_STAT_MEAN (1u << 3)
+#define RS_STAT_VARIANCE (1u << 4)
+#define RS_STAT_STDDEV (1u << 5)
+#define RS_STAT_SKEW (1u << 6)
+#define RS_STAT_KURT (1u << 7)
+#define RS_STAT_ALL 0xffu
+/* output writers only: every series set with rs_rolling_set_quantiles */
+#define RS_STAT_QUANTILES (1u << 8)
+
+/* most quantile series one rolling carries, and their name length */
+#define RS_ROLLING_MAX_QUANTILES 16
+#define RS_ROLLING_QUANTILE_NAME 16
+
+/* X(flag, member, name) for every output series */
+#define RS_ROLLING_SERIES(X)                                                   \
+        X(RS_STAT_SUM, sums, "Sum")                                            \
+        X(RS_STAT_MIN, mins, "Min")                                            \
+        X(RS_STAT_MAX, maxs, "Max")                                            \
+        X(RS_STAT_MEAN, means, "Mean")                                         \
+        X(RS_STAT_VARIANCE, variances, "Variance")                             \
+        X(RS_STAT_STDDEV, stddevs, "Stddev")                                   \
+        X(RS_STAT_SKEW, skews, "Skew")                                         \
+        X(RS_STAT_KURT, kurts, "Kurt")
+
+/* X(order, extrema) for every specialised roll kernel */
+#define RS_ROLLING_KERNELS(X)                                                  \
+        X(0, 0) X(0, 1) X(1, 0) X(1, 1) X(2, 0) X(2, 1) X(3, 0) X(3, 1)        \
+        X(4, 0) X(4, 1)
+
+struct rs_rolling;
+
+typedef void (*rs_rolling_kernel)(struct rs_rolling *r, circular_array *ca,
+                                  const double *src, size_t first,
+                                  size_t last);
+
 typedef struct rs_rolling {
         size_t window;
         size_t count;
+        unsigned int stats;
+        size_t reanchor_interval;
+        rs_rolling_kernel kernel;
         rs_vector *source_data;
         circular_array *window_data;
+        void *arena;
         rs_vector *mins;
         rs_vector *maxs;
         rs_vector *sums;
@@ -16,11 +60,70 @@ typedef struct rs_rolling {
         rs_vector *stddevs;
         rs_vector *skews;
         rs_vector *kurts;
+        size_t n_quantiles;
+        double quantile_levels[RS_ROLLING_MAX_QUANTILES];
+        char quantile_names[RS_ROLLING_MAX_QUANTILES][RS_ROLLING_QUANTILE_NAME];
+        rs_vector *quantiles[RS_ROLLING_MAX_QUANTILES];
+        rs_skiplist *order_stats;
 } rs_rolling;
 
-rs_rolling *rs_rolling_alloc(rs_vector *v, size_t window);
+/* highest central moment needed to produce the selected series */
+static inline int rs_stats_order(unsigned int stats) {
+        if (stats & RS_STAT_KURT)
+                return 4;
+        if (stats & RS_STAT_SKEW)
+                return 3;
+        if (stats & (RS_STAT_VARIANCE | RS_STAT_STDDEV))
+                return 2;
+        if (stats & (RS_STAT_SUM | RS_STAT_MEAN))
+                return 1;
+        return 0;
+}
+
+static inline bool rs_stats_extrema(unsigned int stats) {
+        return (stats & (RS_STAT_MIN | RS_STAT_MAX)) != 0;
+}
+
+/* number of windows that fit in count samples from start_index */
+static inline size_t rs_rolling_output_size(size_t count, size_t start_index,
+                                            size_t window) {
+        if (count < start_index + window) {
+                return 0;
+        }
+        return count - start_index - window + 1;
+}
+
+/* stats is a mask of RS_STAT_* flags, unselected series are left NULL */
+rs_rolling *rs_rolling_alloc(rs_vector *v, size_t window, unsigned int stats);
+/*
+the struct, window and every selected series in one aligned block, output
+capacity fixed at max_rows (0 for the rows v produces now). rolling a
+longer source fails rather than reallocating. rs_rolling_free releases the
+block.
+*/
+rs_rolling *rs_rolling_alloc_arena(rs_vector *v, size_t window,
+                                   unsigned int stats, size_t max_rows);
 void rs_rolling_free(rs_rolling *r);
-void rs_rolling_roll(rs_rolling *r, size_t start_index);
+/* empties window and outputs for a new run, optionally on a new source;
+   -1 for a stats-only source */
+int rs_rolling_reset(rs_rolling *r, rs_vector *v);
+int rs_rolling_roll(rs_rolling *r, size_t start_index);
+int rs_rolling_roll_parallel(rs_rolling *r, size_t start_index,
+                             size_t n_threads);
+void rs_rolling_calculate(rs_rolling *r);
+/*
+adds a rolling quantile series per level in [0, 1] (0.5 is the median,
+0.25 and 0.75 bound the IQR), linearly interpolated between ranks as
+pandas does. filled by every later roll from an indexable skiplist over the
+window, O(log window) per step and level. n of 0 drops them. the series
+are heap allocated even for an arena rolling. a NaN in the source stops
+the quantile pass with one message: that row and every later one of the
+roll (or of the parallel slice) hold NAN and rs_rolling_roll or
+rs_rolling_roll_parallel returns -1.
+*/
+int rs_rolling_set_quantiles(rs_rolling *r, const double *levels, size_t n);
+void rs_rolling_set_accuracy(rs_rolling *r, bool accurate,
+                             size_t reanchor_interval);
 void rs_rolling_print(rs_rolling *r);
 
-#endif
\ No newline at end of file
+#endif
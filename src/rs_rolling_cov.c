@@ -0,0 +1,492 @@
+#include "rs_rolling_cov.h"
+#include <string.h>
+#include "rs_simd.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define RS_COVMAT_X86 1
+#endif
+
+static size_t rs_rolling_pair_output_size(rs_rolling_pair *p,
+                                          size_t start_index) {
+        size_t count = p->x_data->count < p->y_data->count ? p->x_data->count
+                                                           : p->y_data->count;
+        return rs_rolling_output_size(count, start_index, p->window);
+}
+
+rs_rolling_pair *rs_rolling_pair_alloc(rs_vector *x, rs_vector *y,
+                                       size_t window, unsigned int stats) {
+        if (!(stats & RS_PAIR_ALL)) {
+                fprintf(stderr,
+                        "[rs_rolling_pair_alloc] no statistics selected\n");
+                return NULL;
+        }
+        if (window < 1) {
+                fprintf(stderr, "[rs_rolling_pair_alloc] window must be > 0\n");
+                return NULL;
+        }
+        if (!rs_vector_check_data("rs_rolling_pair_alloc", x) ||
+            !rs_vector_check_data("rs_rolling_pair_alloc", y))
+                return NULL;
+        rs_rolling_pair *p = malloc(sizeof(rs_rolling_pair));
+        if (!p) {
+                fprintf(stderr, "[rs_rolling_pair_alloc] malloc error\n");
+                return NULL;
+        }
+        bool failed = false;
+
+        p->window = window;
+        p->count = 0;
+        p->stats = stats & RS_PAIR_ALL;
+        p->reanchor_interval = 0;
+        p->x_data = x;
+        p->y_data = y;
+        rs_comoments_reset(&p->comoments);
+        p->x_window = circular_array_alloc(window, false);
+        p->y_window = circular_array_alloc(window, false);
+        failed |= !p->x_window || !p->y_window;
+        size_t size = rs_rolling_pair_output_size(p, 0);
+#define X(flag, member, name)                                                  \
+        p->member = (p->stats & flag) ? rs_vector_alloc(size) : NULL;          \
+        failed |= (p->stats & flag) && !p->member;
+        RS_ROLLING_PAIR_SERIES(X)
+#undef X
+
+        if (failed) {
+                fprintf(stderr, "[rs_rolling_pair_alloc] malloc error\n");
+                rs_rolling_pair_free(p);
+                return NULL;
+        }
+        return p;
+}
+
+void rs_rolling_pair_free(rs_rolling_pair *p) {
+        if (p) {
+                if (p->x_window)
+                        circular_array_free(p->x_window);
+                if (p->y_window)
+                        circular_array_free(p->y_window);
+#define X(flag, member, name)                                                  \
+        if (p->member)                                                         \
+                rs_vector_free(p->member);
+                RS_ROLLING_PAIR_SERIES(X)
+#undef X
+                free(p);
+                p = NULL;
+        }
+}
+
+static void rs_rolling_pair_set_count(rs_rolling_pair *p, size_t count) {
+#define X(flag, member, name)                                                  \
+        if (p->member)                                                         \
+                p->member->count = count;
+        RS_ROLLING_PAIR_SERIES(X)
+#undef X
+        p->count = count;
+}
+
+/* a stats-only source is refused and p left as it was */
+int rs_rolling_pair_reset(rs_rolling_pair *p, rs_vector *x, rs_vector *y) {
+        if (p) {
+                if ((x && !rs_vector_check_data("rs_rolling_pair_reset", x)) ||
+                    (y && !rs_vector_check_data("rs_rolling_pair_reset", y)))
+                        return -1;
+                if (x)
+                        p->x_data = x;
+                if (y)
+                        p->y_data = y;
+                circular_array_reset(p->x_window);
+                circular_array_reset(p->y_window);
+                rs_comoments_reset(&p->comoments);
+                rs_rolling_pair_set_count(p, 0);
+        }
+        return 0;
+}
+
+void rs_rolling_pair_set_accuracy(rs_rolling_pair *p,
+                                  size_t reanchor_interval) {
+        if (p)
+                p->reanchor_interval = reanchor_interval;
+}
+
+/* two-pass co-moments of the pairs in the windows */
+static void rs_rolling_pair_reanchor(rs_rolling_pair *p, rs_comoments *m) {
+        const double *xs = p->x_window->data, *ys = p->y_window->data;
+        double n = (double)p->window, sum_x = 0.0, sum_y = 0.0;
+
+        for (size_t i = 0; i < p->window; i++) {
+                sum_x += xs[i];
+                sum_y += ys[i];
+        }
+        rs_comoments_reset(m);
+        m->mean_x = sum_x / n;
+        m->mean_y = sum_y / n;
+        for (size_t i = 0; i < p->window; i++) {
+                double dx = xs[i] - m->mean_x, dy = ys[i] - m->mean_y;
+                m->M2x += dx * dx;
+                m->M2y += dy * dy;
+                m->C += dx * dy;
+        }
+}
+
+static RS_ALWAYS_INLINE void rs_rolling_pair_emit(rs_rolling_pair *p,
+                                                  const rs_comoments *m,
+                                                  double n, size_t out) {
+        if (p->covariances)
+                p->covariances->data[out] = rs_comoments_covariance(m, n);
+        if (p->correlations)
+                p->correlations->data[out] = rs_comoments_correlation(m);
+        if (p->slopes)
+                p->slopes->data[out] = rs_comoments_slope(m);
+        if (p->intercepts)
+                p->intercepts->data[out] = rs_comoments_intercept(m);
+}
+
+/* output series are written in place, as in rs_rolling_roll. -1 when the
+   rows cannot be reserved, p left as it was */
+int rs_rolling_pair_roll(rs_rolling_pair *p, size_t start_index) {
+        if (!p)
+                return -1;
+        size_t size = rs_rolling_pair_output_size(p, start_index);
+        int rc = 0;
+
+#define X(flag, member, name)                                                  \
+        if (p->member)                                                         \
+                rc |= rs_vector_reserve(p->member, size);
+        RS_ROLLING_PAIR_SERIES(X)
+#undef X
+        if (rc != 0) {
+                fprintf(stderr,
+                        "[rs_rolling_pair_roll] cannot reserve %zu rows\n",
+                        size);
+                return -1;
+        }
+        rs_rolling_pair_reset(p, NULL, NULL);
+        if (size == 0)
+                return 0;
+
+        const double *xs = p->x_data->data + start_index;
+        const double *ys = p->y_data->data + start_index;
+        double *x_ring = p->x_window->data, *y_ring = p->y_window->data;
+        size_t window = p->window, pos = 0, since_anchor = 0;
+        double n = (double)window;
+        rs_comoments m = p->comoments;
+
+        for (size_t i = 0; i < window; i++) {
+                x_ring[i] = xs[i];
+                y_ring[i] = ys[i];
+                rs_comoments_put(&m, xs[i], ys[i], (double)(i + 1));
+        }
+        rs_rolling_pair_emit(p, &m, n, 0);
+        for (size_t j = 1; j < size; j++) {
+                double x = xs[j + window - 1], y = ys[j + window - 1];
+
+                rs_comoments_pop(&m, x_ring[pos], y_ring[pos], n - 1.0);
+                rs_comoments_put(&m, x, y, n);
+                x_ring[pos] = x;
+                y_ring[pos] = y;
+                if (++pos == window)
+                        pos = 0;
+                if (p->reanchor_interval &&
+                    ++since_anchor == p->reanchor_interval) {
+                        since_anchor = 0;
+                        rs_rolling_pair_reanchor(p, &m);
+                }
+                rs_rolling_pair_emit(p, &m, n, j);
+        }
+        p->x_window->count = window;
+        p->y_window->count = window;
+        p->x_window->head = p->x_window->tail = pos;
+        p->y_window->head = p->y_window->tail = pos;
+        p->comoments = m;
+        rs_rolling_pair_set_count(p, size);
+        return 0;
+}
+
+/*
+the block sweep: C[i][j] += sum_t weights[t] v_t[i] v_t[j] over the upper
+triangle j >= i. row i of C stays in cache across the k vectors, is loaded
+and stored once per four of them, and the inner loop runs over contiguous
+j, so it vectorises; it is compiled once per instruction set and picked
+with rs_simd_get_level, as rs_panel does.
+*/
+
+typedef void (*rs_covmat_kernel)(size_t n, size_t stride, double *C,
+                                 const double *vectors, const double *weights,
+                                 size_t k);
+
+static RS_ALWAYS_INLINE void
+rs_covmat_apply_body(size_t n, size_t stride, double *restrict C,
+                     const double *restrict vectors,
+                     const double *restrict weights, size_t k) {
+        for (size_t i = 0; i < n; i++) {
+                double *restrict row = C + i * stride;
+                size_t t = 0;
+
+                for (; t + 4 <= k; t += 4) {
+                        const double *restrict v0 = vectors + t * stride;
+                        const double *restrict v1 = v0 + stride;
+                        const double *restrict v2 = v1 + stride;
+                        const double *restrict v3 = v2 + stride;
+                        double s0 = weights[t] * v0[i];
+                        double s1 = weights[t + 1] * v1[i];
+                        double s2 = weights[t + 2] * v2[i];
+                        double s3 = weights[t + 3] * v3[i];
+                        for (size_t j = i; j < n; j++)
+                                row[j] += s0 * v0[j] + s1 * v1[j] +
+                                          s2 * v2[j] + s3 * v3[j];
+                }
+                for (; t < k; t++) {
+                        const double *restrict v = vectors + t * stride;
+                        double s = weights[t] * v[i];
+                        for (size_t j = i; j < n; j++)
+                                row[j] += s * v[j];
+                }
+        }
+}
+
+#define RS_COVMAT_KERNEL_DEFINE(isa, attributes)                               \
+        attributes static void rs_covmat_apply_##isa(                          \
+            size_t n, size_t stride, double *C, const double *vectors,         \
+            const double *weights, size_t k) {                                 \
+                rs_covmat_apply_body(n, stride, C, vectors, weights, k);       \
+        }
+
+RS_COVMAT_KERNEL_DEFINE(base, )
+#ifdef RS_COVMAT_X86
+RS_COVMAT_KERNEL_DEFINE(avx2, __attribute__((target("avx2,fma"))))
+RS_COVMAT_KERNEL_DEFINE(avx512, __attribute__((target("avx512f"))))
+#endif
+
+static rs_covmat_kernel rs_covmat_kernel_get(void) {
+#ifdef RS_COVMAT_X86
+        switch (rs_simd_get_level()) {
+        case RS_SIMD_AVX512:
+                return rs_covmat_apply_avx512;
+        case RS_SIMD_AVX2:
+                return rs_covmat_apply_avx2;
+        default:
+                break;
+        }
+#endif
+        return rs_covmat_apply_base;
+}
+
+/* with a measuring arena (base NULL) only sizes the block */
+static rs_rolling_covmat *rs_rolling_covmat_place(rs_arena *a, size_t n_series,
+                                                  size_t window) {
+        rs_rolling_covmat *cm = rs_arena_take(a, sizeof(rs_rolling_covmat));
+        /* rows padded to whole cache lines */
+        size_t per_line = RS_ALLOC_ALIGNMENT / sizeof(double);
+        size_t stride = (n_series + per_line - 1) / per_line * per_line;
+        size_t bytes = stride * sizeof(double);
+        rs_rolling_covmat layout = {0};
+
+        layout.stride = stride;
+        layout.means = rs_arena_take(a, bytes);
+        layout.C = rs_arena_take(a, n_series * bytes);
+        if (window > 0)
+                layout.ring = rs_arena_take(a, window * bytes);
+        layout.vectors = rs_arena_take(a, 2 * RS_COVMAT_BLOCK * bytes);
+        layout.weights =
+            rs_arena_take(a, 2 * RS_COVMAT_BLOCK * sizeof(double));
+        if (cm)
+                *cm = layout;
+        return cm;
+}
+
+rs_rolling_covmat *rs_rolling_covmat_alloc(size_t n_series, size_t window) {
+        if (n_series == 0) {
+                fprintf(stderr, "[rs_rolling_covmat_alloc] no series\n");
+                return NULL;
+        }
+        if (window == 1) {
+                fprintf(stderr,
+                        "[rs_rolling_covmat_alloc] window must be 0 or > 1\n");
+                return NULL;
+        }
+        rs_arena a = {NULL, 0, 0};
+
+        rs_rolling_covmat_place(&a, n_series, window);
+        a.size = a.used;
+        a.used = 0;
+        a.base = rs_allocator_aligned.alloc(NULL, a.size);
+        if (!a.base) {
+                fprintf(stderr, "[rs_rolling_covmat_alloc] malloc error\n");
+                return NULL;
+        }
+        rs_rolling_covmat *cm = rs_rolling_covmat_place(&a, n_series, window);
+        cm->n_series = n_series;
+        cm->window = window;
+        cm->arena = a.base;
+        rs_rolling_covmat_reset(cm);
+        return cm;
+}
+
+void rs_rolling_covmat_free(rs_rolling_covmat *cm) {
+        if (cm) {
+                /* everything, cm included, lives in the block */
+                rs_allocator_aligned.release(NULL, cm->arena, 0);
+        }
+}
+
+void rs_rolling_covmat_reset(rs_rolling_covmat *cm) {
+        size_t bytes = cm->stride * sizeof(double);
+
+        cm->count = 0;
+        cm->pos = 0;
+        memset(cm->means, 0, bytes);
+        memset(cm->C, 0, cm->n_series * bytes);
+}
+
+/*
+with the window full, removing the oldest row y and adding x is
+  a = y - mean, mean_r = mean - a / (w - 1), C -= w / (w - 1) a a'
+  b = x - mean_r, mean' = mean_r + b / w, C += (w - 1) / w b b'
+and while it fills, adding x to c rows is d = x - mean, mean += d / (c + 1),
+C += c / (c + 1) d d'. only the means are updated per row, the rank-1 terms
+are queued and applied a block at a time.
+*/
+void rs_rolling_covmat_update_rows(rs_rolling_covmat *cm, const double *rows,
+                                   size_t n_rows) {
+        rs_covmat_kernel apply = rs_covmat_kernel_get();
+        size_t n = cm->n_series, stride = cm->stride, window = cm->window;
+        double *restrict means = cm->means;
+        size_t k = 0;
+
+        for (size_t r = 0; r < n_rows; r++) {
+                const double *restrict x = rows + r * n;
+
+                if (window > 0 && cm->count == window) {
+                        double w = (double)window;
+                        double *restrict old = cm->ring + cm->pos * stride;
+                        double *restrict a = cm->vectors + k * stride;
+                        double *restrict b = a + stride;
+
+                        for (size_t i = 0; i < n; i++) {
+                                a[i] = old[i] - means[i];
+                                double mean_r = means[i] - a[i] / (w - 1.0);
+                                b[i] = x[i] - mean_r;
+                                means[i] = mean_r + b[i] / w;
+                        }
+                        cm->weights[k] = -w / (w - 1.0);
+                        cm->weights[k + 1] = (w - 1.0) / w;
+                        k += 2;
+                } else {
+                        double c = (double)cm->count;
+                        double *restrict d = cm->vectors + k * stride;
+
+                        for (size_t i = 0; i < n; i++) {
+                                d[i] = x[i] - means[i];
+                                means[i] += d[i] / (c + 1.0);
+                        }
+                        cm->weights[k++] = c / (c + 1.0);
+                        cm->count++;
+                }
+                if (window > 0) {
+                        memcpy(cm->ring + cm->pos * stride, x,
+                               n * sizeof(double));
+                        if (++cm->pos == window)
+                                cm->pos = 0;
+                }
+                if (k + 2 > 2 * RS_COVMAT_BLOCK) {
+                        apply(n, stride, cm->C, cm->vectors, cm->weights, k);
+                        k = 0;
+                }
+        }
+        if (k > 0)
+                apply(n, stride, cm->C, cm->vectors, cm->weights, k);
+}
+
+void rs_rolling_covmat_update_row(rs_rolling_covmat *cm, const double *row) {
+        rs_rolling_covmat_update_rows(cm, row, 1);
+}
+
+void rs_rolling_covmat_reanchor(rs_rolling_covmat *cm) {
+        size_t n = cm->n_series, stride = cm->stride;
+        double count = (double)cm->count;
+
+        if (cm->window == 0 || cm->count == 0) {
+                fprintf(stderr, "[rs_rolling_covmat_reanchor] no window "
+                                "rows to recompute from\n");
+                return;
+        }
+        /* the filled rows are the first count ring slots, in any order */
+        memset(cm->means, 0, stride * sizeof(double));
+        memset(cm->C, 0, n * stride * sizeof(double));
+        for (size_t r = 0; r < cm->count; r++) {
+                const double *row = cm->ring + r * stride;
+                for (size_t i = 0; i < n; i++)
+                        cm->means[i] += row[i];
+        }
+        for (size_t i = 0; i < n; i++)
+                cm->means[i] /= count;
+        rs_covmat_kernel apply = rs_covmat_kernel_get();
+        size_t k = 0;
+        for (size_t r = 0; r < cm->count; r++) {
+                const double *row = cm->ring + r * stride;
+                double *d = cm->vectors + k * stride;
+                for (size_t i = 0; i < n; i++)
+                        d[i] = row[i] - cm->means[i];
+                cm->weights[k++] = 1.0;
+                if (k == 2 * RS_COVMAT_BLOCK) {
+                        apply(n, stride, cm->C, cm->vectors, cm->weights, k);
+                        k = 0;
+                }
+        }
+        if (k > 0)
+                apply(n, stride, cm->C, cm->vectors, cm->weights, k);
+}
+
+double rs_rolling_covmat_get(rs_rolling_covmat *cm, size_t i, size_t j) {
+        if (i >= cm->n_series || j >= cm->n_series) {
+                fprintf(stderr, "[rs_rolling_covmat_get] index out of range "
+                                "%zu\n",
+                        cm->n_series);
+                return 0.0;
+        }
+        if (i > j) {
+                size_t t = i;
+                i = j;
+                j = t;
+        }
+        return cm->C[i * cm->stride + j] / ((double)cm->count - 1.0);
+}
+
+int rs_rolling_covmat_covariance(rs_rolling_covmat *cm, double *out) {
+        size_t n = cm->n_series;
+        double scale = 1.0 / ((double)cm->count - 1.0);
+
+        if (cm->count < 2) {
+                fprintf(stderr,
+                        "[rs_rolling_covmat_covariance] fewer than 2 rows\n");
+                return -1;
+        }
+        for (size_t i = 0; i < n; i++) {
+                for (size_t j = i; j < n; j++) {
+                        double c = cm->C[i * cm->stride + j] * scale;
+                        out[i * n + j] = c;
+                        out[j * n + i] = c;
+                }
+        }
+        return 0;
+}
+
+int rs_rolling_covmat_correlation(rs_rolling_covmat *cm, double *out) {
+        size_t n = cm->n_series, stride = cm->stride;
+
+        if (cm->count < 2) {
+                fprintf(stderr,
+                        "[rs_rolling_covmat_correlation] fewer than 2 rows\n");
+                return -1;
+        }
+        for (size_t i = 0; i < n; i++) {
+                for (size_t j = i; j < n; j++) {
+                        double c = cm->C[i * stride + j] /
+                                   sqrt(cm->C[i * stride + i] *
+                                        cm->C[j * stride + j]);
+                        out[i * n + j] = c;
+                        out[j * n + i] = c;
+                }
+        }
+        return 0;
+}
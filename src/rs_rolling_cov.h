@@ -0,0 +1,98 @@
+#ifndef __RS_ROLLING_COV_H_
+#define __RS_ROLLING_COV_H_
+
+#include "rs_rolling.h"
+
+/* statistic selection flags for rs_rolling_pair_alloc */
+#define RS_PAIR_COV (1u << 0)
+#define RS_PAIR_CORR (1u << 1)
+#define RS_PAIR_SLOPE (1u << 2)
+#define RS_PAIR_INTERCEPT (1u << 3)
+#define RS_PAIR_ALL 0xfu
+
+/* X(flag, member, name) for every output series */
+#define RS_ROLLING_PAIR_SERIES(X)                                              \
+        X(RS_PAIR_COV, covariances, "Cov")                                     \
+        X(RS_PAIR_CORR, correlations, "Corr")                                  \
+        X(RS_PAIR_SLOPE, slopes, "Slope")                                      \
+        X(RS_PAIR_INTERCEPT, intercepts, "Intercept")
+
+/*
+rolling statistics of two aligned series: covariance, Pearson correlation
+and the least squares fit y = intercept + slope * x over each window. the
+windows of x and y sit in two circular_arrays and an rs_comoments is
+updated with one pop and one put per step, so a roll costs O(1) per output
+whatever the window. slot j covers x[j, j + window) and y[j, j + window).
+*/
+
+typedef struct rs_rolling_pair {
+        size_t window;
+        size_t count;
+        unsigned int stats;
+        size_t reanchor_interval;
+        rs_vector *x_data;
+        rs_vector *y_data;
+        circular_array *x_window;
+        circular_array *y_window;
+        rs_comoments comoments;
+        rs_vector *covariances;
+        rs_vector *correlations;
+        rs_vector *slopes;
+        rs_vector *intercepts;
+} rs_rolling_pair;
+
+/* stats is a mask of RS_PAIR_* flags, unselected series are left NULL */
+rs_rolling_pair *rs_rolling_pair_alloc(rs_vector *x, rs_vector *y,
+                                       size_t window, unsigned int stats);
+void rs_rolling_pair_free(rs_rolling_pair *p);
+/* empties window and outputs, optionally on new sources, so one engine
+   can be reused across many pairs; -1 for a stats-only source */
+int rs_rolling_pair_reset(rs_rolling_pair *p, rs_vector *x, rs_vector *y);
+int rs_rolling_pair_roll(rs_rolling_pair *p, size_t start_index);
+/* recompute the co-moments from the windows every reanchor_interval steps
+   (0 never), bounding the drift of long add/remove runs */
+void rs_rolling_pair_set_accuracy(rs_rolling_pair *p, size_t reanchor_interval);
+
+/*
+rolling covariance matrix of n_series series sharing one time axis, fed a
+row at a time like rs_panel. each step is two symmetric rank-1 updates of
+the co-moment matrix (remove the oldest row, add the new one); they are
+queued for RS_COVMAT_BLOCK rows and applied in one sweep over the upper
+triangle, so the matrix is streamed once per block rather than once per
+row, with the sweep vectorised per instruction set. window 0 accumulates
+every row.
+*/
+
+#define RS_COVMAT_BLOCK 8
+
+typedef struct rs_rolling_covmat {
+        size_t n_series;
+        size_t window;
+        size_t count;
+        size_t pos;
+        size_t stride;
+        double *means;
+        double *C;
+        double *ring;
+        double *vectors;
+        double *weights;
+        void *arena;
+} rs_rolling_covmat;
+
+/* window is 0 or at least 2 */
+rs_rolling_covmat *rs_rolling_covmat_alloc(size_t n_series, size_t window);
+void rs_rolling_covmat_free(rs_rolling_covmat *cm);
+void rs_rolling_covmat_reset(rs_rolling_covmat *cm);
+/* row holds one value per series */
+void rs_rolling_covmat_update_row(rs_rolling_covmat *cm, const double *row);
+/* n_rows rows back to back, row-major */
+void rs_rolling_covmat_update_rows(rs_rolling_covmat *cm, const double *rows,
+                                   size_t n_rows);
+/* recomputes means and co-moments from the rows in the window */
+void rs_rolling_covmat_reanchor(rs_rolling_covmat *cm);
+/* full n_series x n_series matrices, row-major */
+int rs_rolling_covmat_covariance(rs_rolling_covmat *cm, double *out);
+int rs_rolling_covmat_correlation(rs_rolling_covmat *cm, double *out);
+double rs_rolling_covmat_get(rs_rolling_covmat *cm, size_t i, size_t j);
+
+#endif
@@ -0,0 +1,219 @@
+#include "rs_rolling_multi.h"
+
+static RS_ALWAYS_INLINE void rs_rolling_window_emit(rs_rolling_window *w,
+                                                    double n, size_t out) {
+        const rs_moments *m = &w->moments;
+
+        if (w->sums)
+                w->sums->data[out] = m->sum;
+        if (w->mins)
+                w->mins->data[out] = monotonic_deque_front(w->min_deque);
+        if (w->maxs)
+                w->maxs->data[out] = monotonic_deque_front(w->max_deque);
+        if (w->means)
+                w->means->data[out] = m->mean;
+        if (w->variances || w->stddevs) {
+                double variance = rs_moments_variance(m, n);
+                if (w->variances)
+                        w->variances->data[out] = variance;
+                if (w->stddevs)
+                        w->stddevs->data[out] = sqrt(variance);
+        }
+        if (w->skews)
+                w->skews->data[out] = rs_moments_skewness(m, n);
+        if (w->kurts)
+                w->kurts->data[out] = rs_moments_kurtosis(m, n);
+}
+
+/* sample i leaves window w at step i + w, its output slot is i - w + 1 */
+static RS_ALWAYS_INLINE void
+rs_rolling_multi_kernel_body(rs_rolling_multi *m, const double *src,
+                             size_t length, const int order,
+                             const bool extrema) {
+        double *history = m->history->data;
+        size_t cap = m->history->size;
+        size_t pos = 0;
+
+        for (size_t i = 0; i < length; i++) {
+                double item = src[i];
+
+                for (size_t k = 0; k < m->n_windows; k++) {
+                        rs_rolling_window *w = &m->windows[k];
+                        double n = (double)w->window;
+
+                        if (i >= w->window) {
+                                size_t back = pos >= w->window
+                                                  ? pos - w->window
+                                                  : pos + cap - w->window;
+                                rs_moments_pop(&w->moments, history[back],
+                                               n - 1.0, order, false);
+                                rs_moments_put(&w->moments, item, n, order,
+                                               false);
+                        } else {
+                                rs_moments_put(&w->moments, item,
+                                               (double)(i + 1), order,
+                                               false);
+                        }
+                        if (extrema) {
+                                if (i >= w->window) {
+                                        monotonic_deque_evict(w->min_deque,
+                                                              i - w->window);
+                                        monotonic_deque_evict(w->max_deque,
+                                                              i - w->window);
+                                }
+                                monotonic_deque_push(w->min_deque, item, i);
+                                monotonic_deque_push(w->max_deque, item, i);
+                        }
+                        if (i + 1 >= w->window) {
+                                rs_rolling_window_emit(w, n,
+                                                       i + 1 - w->window);
+                        }
+                }
+                history[pos] = item;
+                if (++pos == cap)
+                        pos = 0;
+        }
+        m->history->head = pos;
+        m->history->tail = pos;
+}
+
+#define RS_ROLLING_MULTI_KERNEL_DEFINE(order, extrema)                         \
+        static void rs_rolling_multi_kernel_##order##_##extrema(               \
+            rs_rolling_multi *m, const double *src, size_t length) {           \
+                rs_rolling_multi_kernel_body(m, src, length, order, extrema);  \
+        }
+
+#define RS_ROLLING_MULTI_KERNEL_ENTRY(order, extrema)                          \
+        [order][extrema] = rs_rolling_multi_kernel_##order##_##extrema,
+
+RS_ROLLING_KERNELS(RS_ROLLING_MULTI_KERNEL_DEFINE)
+
+static const rs_rolling_multi_kernel rs_rolling_multi_kernels[5][2] = {
+        RS_ROLLING_KERNELS(RS_ROLLING_MULTI_KERNEL_ENTRY)
+};
+
+rs_rolling_multi *rs_rolling_multi_alloc(rs_vector *v, const size_t *windows,
+                                         size_t n_windows, unsigned int stats) {
+        if (n_windows == 0 || !(stats & RS_STAT_ALL)) {
+                fprintf(stderr, "[rs_rolling_multi_alloc] no windows or "
+                                "statistics selected\n");
+                return NULL;
+        }
+        for (size_t k = 0; k < n_windows; k++) {
+                if (windows[k] < 1) {
+                        fprintf(stderr, "[rs_rolling_multi_alloc] window "
+                                        "must be > 0\n");
+                        return NULL;
+                }
+        }
+        if (!rs_vector_check_data("rs_rolling_multi_alloc", v))
+                return NULL;
+        rs_rolling_multi *m = malloc(sizeof(rs_rolling_multi));
+        if (!m) {
+                fprintf(stderr, "[rs_rolling_multi_alloc] malloc error\n");
+                return NULL;
+        }
+        bool extrema = rs_stats_extrema(stats);
+        bool failed = false;
+
+        m->n_windows = n_windows;
+        m->stats = stats & RS_STAT_ALL;
+        m->kernel = rs_rolling_multi_kernels[rs_stats_order(m->stats)]
+                                            [extrema];
+        m->source_data = v;
+        m->max_window = 0;
+        for (size_t k = 0; k < n_windows; k++) {
+                if (windows[k] > m->max_window)
+                        m->max_window = windows[k];
+        }
+        m->history = circular_array_alloc(m->max_window, false);
+        m->windows = calloc(n_windows, sizeof(rs_rolling_window));
+        failed |= !m->history || !m->windows;
+
+        for (size_t k = 0; !failed && k < n_windows; k++) {
+                rs_rolling_window *w = &m->windows[k];
+                size_t size = rs_rolling_output_size(v->count, 0, windows[k]);
+                w->window = windows[k];
+                if (extrema) {
+                        w->min_deque = monotonic_deque_alloc(w->window, true);
+                        w->max_deque = monotonic_deque_alloc(w->window, false);
+                        failed |= !w->min_deque || !w->max_deque;
+                }
+#define X(flag, member, name)                                                  \
+        w->member = (m->stats & flag) ? rs_vector_alloc(size) : NULL;          \
+        failed |= (m->stats & flag) && !w->member;
+                RS_ROLLING_SERIES(X)
+#undef X
+        }
+        if (failed) {
+                fprintf(stderr, "[rs_rolling_multi_alloc] malloc error\n");
+                exit(1);
+        }
+        return m;
+}
+
+void rs_rolling_multi_free(rs_rolling_multi *m) {
+        if (m) {
+                if (m->history) {
+                        circular_array_free(m->history);
+                }
+                for (size_t k = 0; m->windows && k < m->n_windows; k++) {
+                        rs_rolling_window *w = &m->windows[k];
+                        monotonic_deque_free(w->min_deque);
+                        monotonic_deque_free(w->max_deque);
+#define X(flag, member, name)                                                  \
+        if (w->member)                                                         \
+                rs_vector_free(w->member);
+                        RS_ROLLING_SERIES(X)
+#undef X
+                }
+                free(m->windows);
+                free(m);
+                m = NULL;
+        }
+}
+
+/* output series of each window are written in place, as in rs_rolling_roll.
+   -1 when any series cannot be reserved, every window left as it was */
+int rs_rolling_multi_roll(rs_rolling_multi *m, size_t start_index) {
+        int rc = -1;
+
+        if (m) {
+                size_t count = m->source_data->count;
+                size_t length = count > start_index ? count - start_index : 0;
+
+                /* reserve every series before touching any, so a failure
+                   leaves the previous roll intact */
+                for (size_t k = 0; k < m->n_windows; k++) {
+                        rs_rolling_window *w = &m->windows[k];
+                        size_t size = rs_rolling_output_size(
+                            count, start_index, w->window);
+#define X(flag, member, name)                                                  \
+        if (w->member && rs_vector_reserve(w->member, size) != 0) {            \
+                fprintf(stderr, "[rs_rolling_multi_roll] realloc error\n");    \
+                return -1;                                                     \
+        }
+                        RS_ROLLING_SERIES(X)
+#undef X
+                }
+                for (size_t k = 0; k < m->n_windows; k++) {
+                        rs_rolling_window *w = &m->windows[k];
+                        size_t size = rs_rolling_output_size(
+                            count, start_index, w->window);
+
+                        rs_moments_reset(&w->moments);
+                        monotonic_deque_reset(w->min_deque);
+                        monotonic_deque_reset(w->max_deque);
+#define X(flag, member, name)                                                  \
+        if (w->member)                                                         \
+                w->member->count = size;
+                        RS_ROLLING_SERIES(X)
+#undef X
+                        w->count = size;
+                }
+                circular_array_reset(m->history);
+                m->kernel(m, m->source_data->data + start_index, length);
+                rc = 0;
+        }
+        return rc;
+}
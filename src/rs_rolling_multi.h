@@ -0,0 +1,49 @@
+#ifndef __RS_ROLLING_MULTI_H_
+#define __RS_ROLLING_MULTI_H_
+
+#include "rs_rolling.h"
+
+/*
+rolling statistics for several window lengths in one pass. every input
+sample is read once and written once into a single history ring sized to
+the largest window; each window keeps its own moments (and min/max deques)
+and reads the sample it evicts back out of the shared history.
+*/
+
+typedef struct rs_rolling_window {
+        size_t window;
+        size_t count;
+        rs_moments moments;
+        monotonic_deque *min_deque;
+        monotonic_deque *max_deque;
+        rs_vector *mins;
+        rs_vector *maxs;
+        rs_vector *sums;
+        rs_vector *means;
+        rs_vector *variances;
+        rs_vector *stddevs;
+        rs_vector *skews;
+        rs_vector *kurts;
+} rs_rolling_window;
+
+struct rs_rolling_multi;
+
+typedef void (*rs_rolling_multi_kernel)(struct rs_rolling_multi *m,
+                                        const double *src, size_t length);
+
+typedef struct rs_rolling_multi {
+        size_t n_windows;
+        size_t max_window;
+        unsigned int stats;
+        rs_rolling_multi_kernel kernel;
+        rs_vector *source_data;
+        circular_array *history;
+        rs_rolling_window *windows;
+} rs_rolling_multi;
+
+rs_rolling_multi *rs_rolling_multi_alloc(rs_vector *v, const size_t *windows,
+                                         size_t n_windows, unsigned int stats);
+void rs_rolling_multi_free(rs_rolling_multi *m);
+int rs_rolling_multi_roll(rs_rolling_multi *m, size_t start_index);
+
+#endif
@@ -0,0 +1,198 @@
+#include "rs_rolling_stream.h"
+#include "rs_instr.h"
+
+static RS_ALWAYS_INLINE void rs_rolling_stream_row(rs_rolling_stream *s,
+                                                   rs_rolling_row *row) {
+        circular_array *ca = s->window_data;
+        const rs_moments *m = &ca->moments;
+        double n = (double)ca->count;
+        unsigned int stats = s->stats;
+
+        *row = (rs_rolling_row){0};
+        if (stats & RS_STAT_SUM)
+                row->sum = m->sum;
+        if (stats & RS_STAT_MIN)
+                row->min = monotonic_deque_front(ca->min_deque);
+        if (stats & RS_STAT_MAX)
+                row->max = monotonic_deque_front(ca->max_deque);
+        if (stats & RS_STAT_MEAN)
+                row->mean = m->mean;
+        if (stats & (RS_STAT_VARIANCE | RS_STAT_STDDEV)) {
+                double variance = rs_moments_variance(m, n);
+                if (stats & RS_STAT_VARIANCE)
+                        row->variance = variance;
+                if (stats & RS_STAT_STDDEV)
+                        row->stddev = sqrt(variance);
+        }
+        if (stats & RS_STAT_SKEW)
+                row->skew = rs_moments_skewness(m, n);
+        if (stats & RS_STAT_KURT)
+                row->kurt = rs_moments_kurtosis(m, n);
+}
+
+static RS_ALWAYS_INLINE void
+rs_rolling_stream_kernel_body(rs_rolling_stream *s, const double *items,
+                              size_t length, const int order,
+                              const bool extrema) {
+        circular_array *ca = s->window_data;
+        size_t window = s->window;
+
+        for (size_t i = 0; i < length; i++) {
+                double item = items[i];
+
+                if (ca->count == window) {
+                        double evicted = ca->data[ca->tail];
+                        if (++ca->tail == window)
+                                ca->tail = 0;
+                        ca->count--;
+                        rs_moments_pop(&ca->moments, evicted,
+                                       (double)ca->count, order, false);
+                        if (extrema) {
+                                monotonic_deque_evict(ca->min_deque,
+                                                      ca->seq - window);
+                                monotonic_deque_evict(ca->max_deque,
+                                                      ca->seq - window);
+                        }
+                }
+                ca->data[ca->head] = item;
+                if (++ca->head == window)
+                        ca->head = 0;
+                ca->count++;
+                rs_moments_put(&ca->moments, item, (double)ca->count, order,
+                               false);
+                if (extrema) {
+                        monotonic_deque_push(ca->min_deque, item, ca->seq);
+                        monotonic_deque_push(ca->max_deque, item, ca->seq);
+                }
+                ca->seq++;
+
+                if (s->output && ca->count == window) {
+                        rs_rolling_stream_row(s, &s->output[s->output_head]);
+                        if (++s->output_head == s->output_size)
+                                s->output_head = 0;
+                        if (s->output_count < s->output_size)
+                                s->output_count++;
+                }
+        }
+        s->n_samples += length;
+}
+
+#define RS_ROLLING_STREAM_KERNEL_DEFINE(order, extrema)                        \
+        static void rs_rolling_stream_kernel_##order##_##extrema(              \
+            rs_rolling_stream *s, const double *items, size_t length) {        \
+                rs_rolling_stream_kernel_body(s, items, length, order,         \
+                                              extrema);                        \
+        }
+
+#define RS_ROLLING_STREAM_KERNEL_ENTRY(order, extrema)                         \
+        [order][extrema] = rs_rolling_stream_kernel_##order##_##extrema,
+
+RS_ROLLING_KERNELS(RS_ROLLING_STREAM_KERNEL_DEFINE)
+
+static const rs_rolling_stream_kernel rs_rolling_stream_kernels[5][2] = {
+        RS_ROLLING_KERNELS(RS_ROLLING_STREAM_KERNEL_ENTRY)
+};
+
+rs_rolling_stream *rs_rolling_stream_alloc(size_t window, unsigned int stats,
+                                           size_t output_size) {
+        if (!(stats & RS_STAT_ALL)) {
+                fprintf(stderr,
+                        "[rs_rolling_stream_alloc] no statistics selected\n");
+                return NULL;
+        }
+        if (window < 1) {
+                fprintf(stderr,
+                        "[rs_rolling_stream_alloc] window must be > 0\n");
+                return NULL;
+        }
+        rs_rolling_stream *s = malloc(sizeof(rs_rolling_stream));
+        if (!s) {
+                fprintf(stderr, "[rs_rolling_stream_alloc] malloc error\n");
+                return NULL;
+        }
+        s->window = window;
+        s->stats = stats & RS_STAT_ALL;
+        s->kernel = rs_rolling_stream_kernels[rs_stats_order(s->stats)]
+                                             [rs_stats_extrema(s->stats)];
+        s->window_data =
+            circular_array_alloc(window, rs_stats_extrema(s->stats));
+        s->output_size = output_size;
+        s->output = NULL;
+        if (output_size > 0) {
+                s->output = malloc(output_size * sizeof(rs_rolling_row));
+        }
+        if (!s->window_data || (output_size > 0 && !s->output)) {
+                fprintf(stderr, "[rs_rolling_stream_alloc] malloc error\n");
+                rs_rolling_stream_free(s);
+                return NULL;
+        }
+        rs_rolling_stream_reset(s);
+        return s;
+}
+
+void rs_rolling_stream_free(rs_rolling_stream *s) {
+        if (s) {
+                if (s->window_data) {
+                        circular_array_free(s->window_data);
+                }
+                if (s->output) {
+                        free(s->output);
+                }
+                free(s);
+                s = NULL;
+        }
+}
+
+void rs_rolling_stream_reset(rs_rolling_stream *s) {
+        circular_array_reset(s->window_data);
+        s->n_samples = 0;
+        s->output_head = 0;
+        s->output_count = 0;
+}
+
+/* a sample pushed into a full window evicts exactly one */
+static inline void rs_rolling_stream_count(rs_rolling_stream *s, size_t before,
+                                           size_t length) {
+        RS_INSTR_ADD(window_pushes, length);
+        RS_INSTR_ADD(evictions, before + length - s->window_data->count);
+}
+
+void rs_rolling_stream_push(rs_rolling_stream *s, double item) {
+        size_t before = s->window_data->count;
+
+        s->kernel(s, &item, 1);
+        rs_rolling_stream_count(s, before, 1);
+}
+
+void rs_rolling_stream_push_batch(rs_rolling_stream *s, const double *items,
+                                  size_t length) {
+        size_t before = s->window_data->count;
+
+        s->kernel(s, items, length);
+        rs_rolling_stream_count(s, before, length);
+}
+
+/* stats of the samples currently in the window, which may not be full yet */
+void rs_rolling_stream_current(rs_rolling_stream *s, rs_rolling_row *out) {
+        if (circular_array_is_empty(s->window_data)) {
+                *out = (rs_rolling_row){0};
+                return;
+        }
+        rs_rolling_stream_row(s, out);
+}
+
+/* removes the oldest row from the output ring */
+int rs_rolling_stream_pop_output(rs_rolling_stream *s, rs_rolling_row *out) {
+        int rc = -1;
+
+        if (s->output_count > 0) {
+                size_t tail = s->output_head + s->output_size -
+                              s->output_count;
+                if (tail >= s->output_size)
+                        tail -= s->output_size;
+                *out = s->output[tail];
+                s->output_count--;
+                rc = 0;
+        }
+        return rc;
+}
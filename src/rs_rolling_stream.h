@@ -0,0 +1,57 @@
+#ifndef __RS_ROLLING_STREAM_H_
+#define __RS_ROLLING_STREAM_H_
+
+#include "rs_rolling.h"
+
+/*
+online rolling statistics over a circular_array window. samples are pushed
+one at a time or in batches, the current window's stats are available in
+O(1) at any time, and each completed window can optionally be emitted into
+a bounded output ring that overwrites its oldest row when full.
+*/
+
+/* one row of rolling output, unselected statistics are left at 0 */
+typedef struct rs_rolling_row {
+        double sum;
+        double min;
+        double max;
+        double mean;
+        double variance;
+        double stddev;
+        double skew;
+        double kurt;
+} rs_rolling_row;
+
+struct rs_rolling_stream;
+
+typedef void (*rs_rolling_stream_kernel)(struct rs_rolling_stream *s,
+                                         const double *items, size_t length);
+
+typedef struct rs_rolling_stream {
+        size_t window;
+        size_t n_samples;
+        unsigned int stats;
+        rs_rolling_stream_kernel kernel;
+        circular_array *window_data;
+        rs_rolling_row *output;
+        size_t output_size;
+        size_t output_head;
+        size_t output_count;
+} rs_rolling_stream;
+
+/* output_size == 0 disables the output ring */
+rs_rolling_stream *rs_rolling_stream_alloc(size_t window, unsigned int stats,
+                                           size_t output_size);
+void rs_rolling_stream_free(rs_rolling_stream *s);
+void rs_rolling_stream_reset(rs_rolling_stream *s);
+void rs_rolling_stream_push(rs_rolling_stream *s, double item);
+void rs_rolling_stream_push_batch(rs_rolling_stream *s, const double *items,
+                                  size_t length);
+void rs_rolling_stream_current(rs_rolling_stream *s, rs_rolling_row *out);
+int rs_rolling_stream_pop_output(rs_rolling_stream *s, rs_rolling_row *out);
+
+static inline bool rs_rolling_stream_ready(rs_rolling_stream *s) {
+        return circular_array_is_full(s->window_data);
+}
+
+#endif
@@ -0,0 +1,279 @@
+#include "rs_rolling_time.h"
+#include "rs_instr.h"
+
+#define RS_ROLLING_TIME_DEFAULT_SIZE 64
+
+static RS_ALWAYS_INLINE void rs_rolling_time_row(rs_rolling_time *t,
+                                                 rs_rolling_row *row) {
+        circular_array *ca = t->window_data;
+        const rs_moments *m = &ca->moments;
+        double n = (double)ca->count;
+        unsigned int stats = t->stats;
+
+        *row = (rs_rolling_row){0};
+        if (ca->count == 0)
+                return;
+        if (stats & RS_STAT_SUM)
+                row->sum = m->sum;
+        if (stats & RS_STAT_MIN)
+                row->min = monotonic_deque_front(ca->min_deque);
+        if (stats & RS_STAT_MAX)
+                row->max = monotonic_deque_front(ca->max_deque);
+        if (stats & RS_STAT_MEAN)
+                row->mean = m->mean;
+        if (stats & (RS_STAT_VARIANCE | RS_STAT_STDDEV)) {
+                double variance = rs_moments_variance(m, n);
+                if (stats & RS_STAT_VARIANCE)
+                        row->variance = variance;
+                if (stats & RS_STAT_STDDEV)
+                        row->stddev = sqrt(variance);
+        }
+        if (stats & RS_STAT_SKEW)
+                row->skew = rs_moments_skewness(m, n);
+        if (stats & RS_STAT_KURT)
+                row->kurt = rs_moments_kurtosis(m, n);
+}
+
+/* values and stamps move together, oldest first */
+static int rs_rolling_time_resize(rs_rolling_time *t, size_t size) {
+        circular_array *ca = t->window_data;
+        int64_t *stamps = malloc(size * sizeof(int64_t));
+
+        if (!stamps) {
+                fprintf(stderr, "[rs_rolling_time_resize] malloc error\n");
+                return -1;
+        }
+        for (size_t i = 0, pos = ca->tail; i < ca->count; i++) {
+                stamps[i] = t->stamps[pos];
+                if (++pos == ca->size)
+                        pos = 0;
+        }
+        if (circular_array_resize(ca, size) != 0) {
+                free(stamps);
+                return -1;
+        }
+        RS_INSTR_ADD(resizes, 1);
+        RS_INSTR_ADD(resize_bytes,
+                     ca->count * (sizeof(double) + sizeof(int64_t)));
+        free(t->stamps);
+        t->stamps = stamps;
+        return 0;
+}
+
+/* drops every sample stamped at or before now - span in one batch */
+static RS_ALWAYS_INLINE void rs_rolling_time_evict(rs_rolling_time *t,
+                                                   int64_t now,
+                                                   const int order,
+                                                   const bool extrema) {
+        circular_array *ca = t->window_data;
+        size_t k = 0, pos = ca->tail;
+
+        /* below INT64_MIN + span, now - span would overflow and no stamp
+           can be old enough to leave */
+        if (now < INT64_MIN + t->span)
+                return;
+        int64_t cutoff = now - t->span;
+        while (k < ca->count && t->stamps[pos] <= cutoff) {
+                k++;
+                if (++pos == ca->size)
+                        pos = 0;
+        }
+        if (k == 0)
+                return;
+
+        size_t remaining = ca->count - k;
+        if (order > 0 && k < remaining) {
+                for (size_t i = 0; i < k; i++) {
+                        double evicted = ca->data[ca->tail];
+                        if (++ca->tail == ca->size)
+                                ca->tail = 0;
+                        ca->count--;
+                        rs_moments_pop(&ca->moments, evicted,
+                                       (double)ca->count, order, false);
+                }
+        } else {
+                ca->tail = pos;
+                ca->count = remaining;
+                if (order > 0 && remaining > 0)
+                        circular_array_reanchor(ca);
+                else
+                        rs_moments_reset(&ca->moments);
+        }
+        if (extrema) {
+                monotonic_deque_evict_before(ca->min_deque,
+                                             ca->seq - ca->count);
+                monotonic_deque_evict_before(ca->max_deque,
+                                             ca->seq - ca->count);
+        }
+        if (!t->reuse && ca->size > t->min_size && ca->count * 4 <= ca->size) {
+                size_t size = ca->size / 2;
+                rs_rolling_time_resize(t, size > t->min_size ? size
+                                                             : t->min_size);
+        }
+}
+
+static RS_ALWAYS_INLINE int
+rs_rolling_time_kernel_body(rs_rolling_time *t, const int64_t *stamps,
+                            const double *values, size_t length,
+                            rs_rolling_row *out, const int order,
+                            const bool extrema) {
+        circular_array *ca = t->window_data;
+
+        for (size_t i = 0; i < length; i++) {
+                int64_t stamp = stamps[i];
+                double item = values[i];
+
+                if (stamp < t->last_stamp) {
+                        fprintf(stderr, "[rs_rolling_time_push] stamp "
+                                        "%lld before %lld\n",
+                                (long long)stamp, (long long)t->last_stamp);
+                        t->n_samples += i;
+                        return -1;
+                }
+                t->last_stamp = stamp;
+                rs_rolling_time_evict(t, stamp, order, extrema);
+                if (ca->count == ca->size &&
+                    rs_rolling_time_resize(t, ca->size * 2) != 0) {
+                        t->n_samples += i;
+                        return -1;
+                }
+                ca->data[ca->head] = item;
+                t->stamps[ca->head] = stamp;
+                if (++ca->head == ca->size)
+                        ca->head = 0;
+                ca->count++;
+                rs_moments_put(&ca->moments, item, (double)ca->count, order,
+                               false);
+                if (extrema) {
+                        monotonic_deque_push(ca->min_deque, item, ca->seq);
+                        monotonic_deque_push(ca->max_deque, item, ca->seq);
+                }
+                ca->seq++;
+                if (out)
+                        rs_rolling_time_row(t, &out[i]);
+        }
+        t->n_samples += length;
+        return 0;
+}
+
+#define RS_ROLLING_TIME_KERNEL_DEFINE(order, extrema)                          \
+        static int rs_rolling_time_kernel_##order##_##extrema(                 \
+            rs_rolling_time *t, const int64_t *stamps, const double *values,   \
+            size_t length, rs_rolling_row *out) {                              \
+                return rs_rolling_time_kernel_body(t, stamps, values, length,  \
+                                                   out, order, extrema);       \
+        }
+
+#define RS_ROLLING_TIME_KERNEL_ENTRY(order, extrema)                           \
+        [order][extrema] = rs_rolling_time_kernel_##order##_##extrema,
+
+RS_ROLLING_KERNELS(RS_ROLLING_TIME_KERNEL_DEFINE)
+
+static const rs_rolling_time_kernel rs_rolling_time_kernels[5][2] = {
+        RS_ROLLING_KERNELS(RS_ROLLING_TIME_KERNEL_ENTRY)
+};
+
+rs_rolling_time *rs_rolling_time_alloc(int64_t span, unsigned int stats,
+                                       size_t capacity) {
+        if (!(stats & RS_STAT_ALL)) {
+                fprintf(stderr,
+                        "[rs_rolling_time_alloc] no statistics selected\n");
+                return NULL;
+        }
+        if (span < 1) {
+                fprintf(stderr, "[rs_rolling_time_alloc] span must be > 0\n");
+                return NULL;
+        }
+        rs_rolling_time *t = malloc(sizeof(rs_rolling_time));
+        if (!t) {
+                fprintf(stderr, "[rs_rolling_time_alloc] malloc error\n");
+                return NULL;
+        }
+        if (capacity == 0)
+                capacity = RS_ROLLING_TIME_DEFAULT_SIZE;
+        t->span = span;
+        t->stats = stats & RS_STAT_ALL;
+        t->reuse = true;
+        t->min_size = capacity;
+        t->kernel = rs_rolling_time_kernels[rs_stats_order(t->stats)]
+                                           [rs_stats_extrema(t->stats)];
+        t->window_data =
+            circular_array_alloc(capacity, rs_stats_extrema(t->stats));
+        t->stamps = malloc(capacity * sizeof(int64_t));
+        if (!t->window_data || !t->stamps) {
+                fprintf(stderr, "[rs_rolling_time_alloc] malloc error\n");
+                rs_rolling_time_free(t);
+                return NULL;
+        }
+        rs_rolling_time_reset(t);
+        return t;
+}
+
+void rs_rolling_time_free(rs_rolling_time *t) {
+        if (t) {
+                if (t->window_data) {
+                        circular_array_free(t->window_data);
+                }
+                free(t->stamps);
+                free(t);
+                t = NULL;
+        }
+}
+
+void rs_rolling_time_reset(rs_rolling_time *t) {
+        circular_array_reset(t->window_data);
+        t->n_samples = 0;
+        t->last_stamp = INT64_MIN;
+}
+
+void rs_rolling_time_set_reuse(rs_rolling_time *t, bool reuse) {
+        t->reuse = reuse;
+}
+
+/* whatever was in the window or pushed and is no longer there left it */
+static inline void rs_rolling_time_count_pushes(rs_rolling_time *t,
+                                                size_t before,
+                                                size_t n_samples) {
+        size_t pushed = t->n_samples - n_samples;
+
+        RS_INSTR_ADD(window_pushes, pushed);
+        RS_INSTR_ADD(evictions, before + pushed - t->window_data->count);
+}
+
+int rs_rolling_time_push(rs_rolling_time *t, int64_t stamp, double value) {
+        size_t before = t->window_data->count, n_samples = t->n_samples;
+        int rc = t->kernel(t, &stamp, &value, 1, NULL);
+
+        rs_rolling_time_count_pushes(t, before, n_samples);
+        return rc;
+}
+
+int rs_rolling_time_push_batch(rs_rolling_time *t, const int64_t *stamps,
+                               const double *values, size_t length,
+                               rs_rolling_row *out) {
+        size_t before = t->window_data->count, n_samples = t->n_samples;
+        int rc = t->kernel(t, stamps, values, length, out);
+
+        rs_rolling_time_count_pushes(t, before, n_samples);
+        return rc;
+}
+
+int rs_rolling_time_advance(rs_rolling_time *t, int64_t now) {
+        if (now < t->last_stamp) {
+                fprintf(stderr, "[rs_rolling_time_advance] time %lld before "
+                                "%lld\n",
+                        (long long)now, (long long)t->last_stamp);
+                return -1;
+        }
+        size_t before = t->window_data->count;
+
+        t->last_stamp = now;
+        rs_rolling_time_evict(t, now, rs_stats_order(t->stats),
+                              rs_stats_extrema(t->stats));
+        RS_INSTR_ADD(evictions, before - t->window_data->count);
+        return 0;
+}
+
+void rs_rolling_time_current(rs_rolling_time *t, rs_rolling_row *out) {
+        rs_rolling_time_row(t, out);
+}
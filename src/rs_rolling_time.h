@@ -0,0 +1,65 @@
+#ifndef __RS_ROLLING_TIME_H_
+#define __RS_ROLLING_TIME_H_
+
+#include <stdint.h>
+#include "rs_rolling_stream.h"
+
+/*
+rolling statistics over a time span rather than a sample count. every value
+comes with an int64 timestamp (any unit, non-decreasing) and the window at
+time t holds the samples stamped in (t - span, t], so it holds however many
+samples arrived in the last span. values sit in a circular_array with the
+stamps in a parallel ring, and both grow geometrically when a burst
+overflows them. everything that falls out of the span is evicted as one
+batch: popped one by one when few go, and, once at least as many leave as
+stay, dropped at once with the moments recomputed from what stays, which
+costs no more than the pops and discards their drift.
+*/
+
+struct rs_rolling_time;
+
+typedef int (*rs_rolling_time_kernel)(struct rs_rolling_time *t,
+                                      const int64_t *stamps,
+                                      const double *values, size_t length,
+                                      rs_rolling_row *out);
+
+typedef struct rs_rolling_time {
+        int64_t span;
+        int64_t last_stamp;
+        size_t n_samples;
+        size_t min_size;
+        unsigned int stats;
+        bool reuse;
+        rs_rolling_time_kernel kernel;
+        circular_array *window_data;
+        int64_t *stamps;
+} rs_rolling_time;
+
+/* capacity is the initial ring size, 0 for a default */
+rs_rolling_time *rs_rolling_time_alloc(int64_t span, unsigned int stats,
+                                       size_t capacity);
+void rs_rolling_time_free(rs_rolling_time *t);
+/* empties the window, the ring keeps its size */
+void rs_rolling_time_reset(rs_rolling_time *t);
+/*
+reuse (the default) keeps the ring at the largest size a burst needed, so
+a steady state never reallocates. without it the ring halves, down to its
+initial size, whenever an eviction leaves it a quarter full.
+*/
+void rs_rolling_time_set_reuse(rs_rolling_time *t, bool reuse);
+/* -1 on a stamp older than the previous one */
+int rs_rolling_time_push(rs_rolling_time *t, int64_t stamp, double value);
+/* out, when not NULL, receives the window after each of the length pushes */
+int rs_rolling_time_push_batch(rs_rolling_time *t, const int64_t *stamps,
+                               const double *values, size_t length,
+                               rs_rolling_row *out);
+/* evicts up to time now without adding a sample */
+int rs_rolling_time_advance(rs_rolling_time *t, int64_t now);
+/* stats of the samples in the window, zeros when it is empty */
+void rs_rolling_time_current(rs_rolling_time *t, rs_rolling_row *out);
+
+static inline size_t rs_rolling_time_count(rs_rolling_time *t) {
+        return t->window_data->count;
+}
+
+#endif
@@ -0,0 +1,584 @@
+#include "rs_simd.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define RS_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+/*
+each block is summarised in two passes over L1-resident data: the first
+accumulates sum/min/max per lane, the second the central power sums about the
+block mean per lane. lanes share the block mean, so the Chan/Pebay merge of
+the lanes reduces to adding their power sums; blocks are then merged with
+rs_stats_combine. this keeps the inner loops free of divides and of the
+serial dependency chain in rs_vector_update.
+*/
+
+typedef void (*rs_simd_block_fn)(const double *data, size_t length,
+                                 rs_stats *out);
+
+static void rs_simd_block_finish(rs_stats *out, size_t length, double sum,
+                                 double min, double max, double M2, double M3,
+                                 double M4) {
+        out->count = length;
+        out->sum = sum;
+        out->min = min;
+        out->max = max;
+        out->mean = sum / (double)length;
+        out->M2 = M2;
+        out->M3 = M3;
+        out->M4 = M4;
+}
+
+static void rs_simd_block_scalar(const double *data, size_t length,
+                                 rs_stats *out) {
+        double sum = 0.0, min = data[0], max = data[0];
+        double M2 = 0.0, M3 = 0.0, M4 = 0.0;
+
+        for (size_t i = 0; i < length; i++) {
+                sum += data[i];
+                if (data[i] < min)
+                        min = data[i];
+                if (data[i] > max)
+                        max = data[i];
+        }
+        double mean = sum / (double)length;
+        for (size_t i = 0; i < length; i++) {
+                double d = data[i] - mean;
+                double d2 = d * d;
+                M2 += d2;
+                M3 += d2 * d;
+                M4 += d2 * d2;
+        }
+        rs_simd_block_finish(out, length, sum, min, max, M2, M3, M4);
+}
+
+/*
+element-wise kernels. a binary op overwrites a with a op b; dot accumulates
+a.b, a.a and b.b in one sweep. the wrappers at the bottom run them a block
+at a time and summarise each freshly written block while it is still in L1,
+so the result's running stats cost no extra pass over memory.
+*/
+
+typedef void (*rs_simd_binary_fn)(double *a, const double *b, size_t length);
+typedef void (*rs_simd_axpy_fn)(double *a, double k, const double *b,
+                                size_t length);
+typedef void (*rs_simd_dot_fn)(const double *a, const double *b,
+                               size_t length, double out[3]);
+
+#define RS_SIMD_BINARY_SCALAR(name, op)                                        \
+        static void rs_simd_##name##_scalar(double *a, const double *b,        \
+                                            size_t length) {                   \
+                for (size_t i = 0; i < length; i++)                            \
+                        a[i] = a[i] op b[i];                                   \
+        }
+
+RS_SIMD_BINARY_SCALAR(add, +)
+RS_SIMD_BINARY_SCALAR(sub, -)
+RS_SIMD_BINARY_SCALAR(mul, *)
+RS_SIMD_BINARY_SCALAR(div, /)
+
+static void rs_simd_axpy_scalar(double *a, double k, const double *b,
+                                size_t length) {
+        for (size_t i = 0; i < length; i++)
+                a[i] += k * b[i];
+}
+
+static void rs_simd_dot_scalar(const double *a, const double *b,
+                               size_t length, double out[3]) {
+        double ab = 0.0, aa = 0.0, bb = 0.0;
+
+        for (size_t i = 0; i < length; i++) {
+                ab += a[i] * b[i];
+                aa += a[i] * a[i];
+                bb += b[i] * b[i];
+        }
+        out[0] = ab;
+        out[1] = aa;
+        out[2] = bb;
+}
+
+#ifdef RS_SIMD_X86
+
+static double rs_simd_hsum_sse2(__m128d v) {
+        return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+static double rs_simd_hmin_sse2(__m128d v) {
+        return _mm_cvtsd_f64(_mm_min_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+static double rs_simd_hmax_sse2(__m128d v) {
+        return _mm_cvtsd_f64(_mm_max_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+static void rs_simd_block_sse2(const double *data, size_t length,
+                               rs_stats *out) {
+        size_t i = 0, vlen = length & ~(size_t)3;
+        __m128d s0 = _mm_setzero_pd(), s1 = _mm_setzero_pd();
+        __m128d mn = _mm_set1_pd(data[0]), mx = mn;
+
+        for (; i < vlen; i += 4) {
+                __m128d a = _mm_loadu_pd(data + i);
+                __m128d b = _mm_loadu_pd(data + i + 2);
+                s0 = _mm_add_pd(s0, a);
+                s1 = _mm_add_pd(s1, b);
+                mn = _mm_min_pd(mn, _mm_min_pd(a, b));
+                mx = _mm_max_pd(mx, _mm_max_pd(a, b));
+        }
+        double sum = rs_simd_hsum_sse2(_mm_add_pd(s0, s1));
+        double min = rs_simd_hmin_sse2(mn), max = rs_simd_hmax_sse2(mx);
+        for (; i < length; i++) {
+                sum += data[i];
+                if (data[i] < min)
+                        min = data[i];
+                if (data[i] > max)
+                        max = data[i];
+        }
+
+        double mean = sum / (double)length;
+        __m128d vmean = _mm_set1_pd(mean);
+        __m128d m2 = _mm_setzero_pd(), m3 = _mm_setzero_pd();
+        __m128d m4 = _mm_setzero_pd();
+        for (i = 0; i < vlen; i += 2) {
+                __m128d d = _mm_sub_pd(_mm_loadu_pd(data + i), vmean);
+                __m128d d2 = _mm_mul_pd(d, d);
+                m2 = _mm_add_pd(m2, d2);
+                m3 = _mm_add_pd(m3, _mm_mul_pd(d2, d));
+                m4 = _mm_add_pd(m4, _mm_mul_pd(d2, d2));
+        }
+        double M2 = rs_simd_hsum_sse2(m2), M3 = rs_simd_hsum_sse2(m3);
+        double M4 = rs_simd_hsum_sse2(m4);
+        for (; i < length; i++) {
+                double d = data[i] - mean;
+                double d2 = d * d;
+                M2 += d2;
+                M3 += d2 * d;
+                M4 += d2 * d2;
+        }
+        rs_simd_block_finish(out, length, sum, min, max, M2, M3, M4);
+}
+
+__attribute__((target("avx2,fma"))) static double
+rs_simd_hsum_avx2(__m256d v) {
+        __m128d lo = _mm256_castpd256_pd128(v);
+        __m128d hi = _mm256_extractf128_pd(v, 1);
+        lo = _mm_add_pd(lo, hi);
+        return _mm_cvtsd_f64(_mm_add_sd(lo, _mm_unpackhi_pd(lo, lo)));
+}
+
+__attribute__((target("avx2,fma"))) static double
+rs_simd_hmin_avx2(__m256d v) {
+        __m128d lo = _mm256_castpd256_pd128(v);
+        __m128d hi = _mm256_extractf128_pd(v, 1);
+        lo = _mm_min_pd(lo, hi);
+        return _mm_cvtsd_f64(_mm_min_sd(lo, _mm_unpackhi_pd(lo, lo)));
+}
+
+__attribute__((target("avx2,fma"))) static double
+rs_simd_hmax_avx2(__m256d v) {
+        __m128d lo = _mm256_castpd256_pd128(v);
+        __m128d hi = _mm256_extractf128_pd(v, 1);
+        lo = _mm_max_pd(lo, hi);
+        return _mm_cvtsd_f64(_mm_max_sd(lo, _mm_unpackhi_pd(lo, lo)));
+}
+
+__attribute__((target("avx2,fma"))) static void
+rs_simd_block_avx2(const double *data, size_t length, rs_stats *out) {
+        size_t i = 0, vlen = length & ~(size_t)7;
+        __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+        __m256d mn = _mm256_set1_pd(data[0]), mx = mn;
+
+        for (; i < vlen; i += 8) {
+                __m256d a = _mm256_loadu_pd(data + i);
+                __m256d b = _mm256_loadu_pd(data + i + 4);
+                s0 = _mm256_add_pd(s0, a);
+                s1 = _mm256_add_pd(s1, b);
+                mn = _mm256_min_pd(mn, _mm256_min_pd(a, b));
+                mx = _mm256_max_pd(mx, _mm256_max_pd(a, b));
+        }
+        double sum = rs_simd_hsum_avx2(_mm256_add_pd(s0, s1));
+        double min = rs_simd_hmin_avx2(mn), max = rs_simd_hmax_avx2(mx);
+        for (; i < length; i++) {
+                sum += data[i];
+                if (data[i] < min)
+                        min = data[i];
+                if (data[i] > max)
+                        max = data[i];
+        }
+
+        double mean = sum / (double)length;
+        __m256d vmean = _mm256_set1_pd(mean);
+        __m256d m2 = _mm256_setzero_pd(), m3 = _mm256_setzero_pd();
+        __m256d m4 = _mm256_setzero_pd();
+        for (i = 0; i < vlen; i += 4) {
+                __m256d d = _mm256_sub_pd(_mm256_loadu_pd(data + i), vmean);
+                __m256d d2 = _mm256_mul_pd(d, d);
+                m2 = _mm256_add_pd(m2, d2);
+                m3 = _mm256_fmadd_pd(d2, d, m3);
+                m4 = _mm256_fmadd_pd(d2, d2, m4);
+        }
+        double M2 = rs_simd_hsum_avx2(m2), M3 = rs_simd_hsum_avx2(m3);
+        double M4 = rs_simd_hsum_avx2(m4);
+        for (; i < length; i++) {
+                double d = data[i] - mean;
+                double d2 = d * d;
+                M2 += d2;
+                M3 += d2 * d;
+                M4 += d2 * d2;
+        }
+        rs_simd_block_finish(out, length, sum, min, max, M2, M3, M4);
+}
+
+__attribute__((target("avx512f"))) static void
+rs_simd_block_avx512(const double *data, size_t length, rs_stats *out) {
+        size_t i = 0, vlen = length & ~(size_t)15;
+        __m512d s0 = _mm512_setzero_pd(), s1 = _mm512_setzero_pd();
+        __m512d mn = _mm512_set1_pd(data[0]), mx = mn;
+
+        for (; i < vlen; i += 16) {
+                __m512d a = _mm512_loadu_pd(data + i);
+                __m512d b = _mm512_loadu_pd(data + i + 8);
+                s0 = _mm512_add_pd(s0, a);
+                s1 = _mm512_add_pd(s1, b);
+                mn = _mm512_min_pd(mn, _mm512_min_pd(a, b));
+                mx = _mm512_max_pd(mx, _mm512_max_pd(a, b));
+        }
+        double sum = _mm512_reduce_add_pd(_mm512_add_pd(s0, s1));
+        double min = _mm512_reduce_min_pd(mn), max = _mm512_reduce_max_pd(mx);
+        for (; i < length; i++) {
+                sum += data[i];
+                if (data[i] < min)
+                        min = data[i];
+                if (data[i] > max)
+                        max = data[i];
+        }
+
+        double mean = sum / (double)length;
+        __m512d vmean = _mm512_set1_pd(mean);
+        __m512d m2 = _mm512_setzero_pd(), m3 = _mm512_setzero_pd();
+        __m512d m4 = _mm512_setzero_pd();
+        for (i = 0; i < vlen; i += 8) {
+                __m512d d = _mm512_sub_pd(_mm512_loadu_pd(data + i), vmean);
+                __m512d d2 = _mm512_mul_pd(d, d);
+                m2 = _mm512_add_pd(m2, d2);
+                m3 = _mm512_fmadd_pd(d2, d, m3);
+                m4 = _mm512_fmadd_pd(d2, d2, m4);
+        }
+        double M2 = _mm512_reduce_add_pd(m2), M3 = _mm512_reduce_add_pd(m3);
+        double M4 = _mm512_reduce_add_pd(m4);
+        for (; i < length; i++) {
+                double d = data[i] - mean;
+                double d2 = d * d;
+                M2 += d2;
+                M3 += d2 * d;
+                M4 += d2 * d2;
+        }
+        rs_simd_block_finish(out, length, sum, min, max, M2, M3, M4);
+}
+
+#define RS_SIMD_BINARY_VEC(name, isa, features, vtype, width, load, store,   \
+                           intrin, op)                                         \
+        __attribute__((target(features))) static void                         \
+            rs_simd_##name##_##isa(double *a, const double *b,                 \
+                                   size_t length) {                            \
+                size_t i = 0;                                                  \
+                for (; i + width <= length; i += width) {                      \
+                        vtype va = load(a + i), vb = load(b + i);              \
+                        store(a + i, intrin(va, vb));                          \
+                }                                                              \
+                for (; i < length; i++)                                        \
+                        a[i] = a[i] op b[i];                                   \
+        }
+
+#define RS_SIMD_BINARY_SSE2(name, intrin, op)                                  \
+        RS_SIMD_BINARY_VEC(name, sse2, "sse2", __m128d, 2, _mm_loadu_pd,       \
+                           _mm_storeu_pd, intrin, op)
+#define RS_SIMD_BINARY_AVX2(name, intrin, op)                                  \
+        RS_SIMD_BINARY_VEC(name, avx2, "avx2,fma", __m256d, 4,                 \
+                           _mm256_loadu_pd, _mm256_storeu_pd, intrin, op)
+#define RS_SIMD_BINARY_AVX512(name, intrin, op)                                \
+        RS_SIMD_BINARY_VEC(name, avx512, "avx512f", __m512d, 8,                \
+                           _mm512_loadu_pd, _mm512_storeu_pd, intrin, op)
+
+RS_SIMD_BINARY_SSE2(add, _mm_add_pd, +)
+RS_SIMD_BINARY_SSE2(sub, _mm_sub_pd, -)
+RS_SIMD_BINARY_SSE2(mul, _mm_mul_pd, *)
+RS_SIMD_BINARY_SSE2(div, _mm_div_pd, /)
+RS_SIMD_BINARY_AVX2(add, _mm256_add_pd, +)
+RS_SIMD_BINARY_AVX2(sub, _mm256_sub_pd, -)
+RS_SIMD_BINARY_AVX2(mul, _mm256_mul_pd, *)
+RS_SIMD_BINARY_AVX2(div, _mm256_div_pd, /)
+RS_SIMD_BINARY_AVX512(add, _mm512_add_pd, +)
+RS_SIMD_BINARY_AVX512(sub, _mm512_sub_pd, -)
+RS_SIMD_BINARY_AVX512(mul, _mm512_mul_pd, *)
+RS_SIMD_BINARY_AVX512(div, _mm512_div_pd, /)
+
+static void rs_simd_axpy_sse2(double *a, double k, const double *b,
+                              size_t length) {
+        size_t i = 0;
+        __m128d vk = _mm_set1_pd(k);
+
+        for (; i + 2 <= length; i += 2) {
+                __m128d vb = _mm_mul_pd(vk, _mm_loadu_pd(b + i));
+                _mm_storeu_pd(a + i, _mm_add_pd(_mm_loadu_pd(a + i), vb));
+        }
+        for (; i < length; i++)
+                a[i] += k * b[i];
+}
+
+__attribute__((target("avx2,fma"))) static void
+rs_simd_axpy_avx2(double *a, double k, const double *b, size_t length) {
+        size_t i = 0;
+        __m256d vk = _mm256_set1_pd(k);
+
+        for (; i + 4 <= length; i += 4) {
+                __m256d va = _mm256_loadu_pd(a + i);
+                _mm256_storeu_pd(a + i,
+                                 _mm256_fmadd_pd(vk, _mm256_loadu_pd(b + i),
+                                                 va));
+        }
+        for (; i < length; i++)
+                a[i] += k * b[i];
+}
+
+__attribute__((target("avx512f"))) static void
+rs_simd_axpy_avx512(double *a, double k, const double *b, size_t length) {
+        size_t i = 0;
+        __m512d vk = _mm512_set1_pd(k);
+
+        for (; i + 8 <= length; i += 8) {
+                __m512d va = _mm512_loadu_pd(a + i);
+                _mm512_storeu_pd(a + i,
+                                 _mm512_fmadd_pd(vk, _mm512_loadu_pd(b + i),
+                                                 va));
+        }
+        for (; i < length; i++)
+                a[i] += k * b[i];
+}
+
+static void rs_simd_dot_sse2(const double *a, const double *b, size_t length,
+                             double out[3]) {
+        size_t i = 0;
+        __m128d ab = _mm_setzero_pd(), aa = _mm_setzero_pd();
+        __m128d bb = _mm_setzero_pd();
+
+        for (; i + 2 <= length; i += 2) {
+                __m128d va = _mm_loadu_pd(a + i), vb = _mm_loadu_pd(b + i);
+                ab = _mm_add_pd(ab, _mm_mul_pd(va, vb));
+                aa = _mm_add_pd(aa, _mm_mul_pd(va, va));
+                bb = _mm_add_pd(bb, _mm_mul_pd(vb, vb));
+        }
+        out[0] = rs_simd_hsum_sse2(ab);
+        out[1] = rs_simd_hsum_sse2(aa);
+        out[2] = rs_simd_hsum_sse2(bb);
+        for (; i < length; i++) {
+                out[0] += a[i] * b[i];
+                out[1] += a[i] * a[i];
+                out[2] += b[i] * b[i];
+        }
+}
+
+__attribute__((target("avx2,fma"))) static void
+rs_simd_dot_avx2(const double *a, const double *b, size_t length,
+                 double out[3]) {
+        size_t i = 0;
+        __m256d ab = _mm256_setzero_pd(), aa = _mm256_setzero_pd();
+        __m256d bb = _mm256_setzero_pd();
+
+        for (; i + 4 <= length; i += 4) {
+                __m256d va = _mm256_loadu_pd(a + i);
+                __m256d vb = _mm256_loadu_pd(b + i);
+                ab = _mm256_fmadd_pd(va, vb, ab);
+                aa = _mm256_fmadd_pd(va, va, aa);
+                bb = _mm256_fmadd_pd(vb, vb, bb);
+        }
+        out[0] = rs_simd_hsum_avx2(ab);
+        out[1] = rs_simd_hsum_avx2(aa);
+        out[2] = rs_simd_hsum_avx2(bb);
+        for (; i < length; i++) {
+                out[0] += a[i] * b[i];
+                out[1] += a[i] * a[i];
+                out[2] += b[i] * b[i];
+        }
+}
+
+__attribute__((target("avx512f"))) static void
+rs_simd_dot_avx512(const double *a, const double *b, size_t length,
+                   double out[3]) {
+        size_t i = 0;
+        __m512d ab = _mm512_setzero_pd(), aa = _mm512_setzero_pd();
+        __m512d bb = _mm512_setzero_pd();
+
+        for (; i + 8 <= length; i += 8) {
+                __m512d va = _mm512_loadu_pd(a + i);
+                __m512d vb = _mm512_loadu_pd(b + i);
+                ab = _mm512_fmadd_pd(va, vb, ab);
+                aa = _mm512_fmadd_pd(va, va, aa);
+                bb = _mm512_fmadd_pd(vb, vb, bb);
+        }
+        out[0] = _mm512_reduce_add_pd(ab);
+        out[1] = _mm512_reduce_add_pd(aa);
+        out[2] = _mm512_reduce_add_pd(bb);
+        for (; i < length; i++) {
+                out[0] += a[i] * b[i];
+                out[1] += a[i] * a[i];
+                out[2] += b[i] * b[i];
+        }
+}
+
+#endif
+
+/* -1 until first use. read and written with relaxed atomics since the
+   first rs_simd_get_level can come from several workers at once; the
+   compare-exchange keeps a racing detection from undoing rs_simd_set_level */
+static int rs_simd_level_cache = -1;
+
+rs_simd_level rs_simd_detect(void) {
+#ifdef RS_SIMD_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f"))
+                return RS_SIMD_AVX512;
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+                return RS_SIMD_AVX2;
+        if (__builtin_cpu_supports("sse2"))
+                return RS_SIMD_SSE2;
+#endif
+        return RS_SIMD_SCALAR;
+}
+
+rs_simd_level rs_simd_get_level(void) {
+        int level = __atomic_load_n(&rs_simd_level_cache, __ATOMIC_RELAXED);
+
+        if (level < 0) {
+                int expected = -1;
+                level = (int)rs_simd_detect();
+                if (!__atomic_compare_exchange_n(&rs_simd_level_cache,
+                                                 &expected, level, false,
+                                                 __ATOMIC_RELAXED,
+                                                 __ATOMIC_RELAXED))
+                        level = expected;
+        }
+        return (rs_simd_level)level;
+}
+
+/* levels above what the cpu supports are clamped */
+void rs_simd_set_level(rs_simd_level level) {
+        rs_simd_level detected = rs_simd_detect();
+        __atomic_store_n(&rs_simd_level_cache,
+                         (int)(level > detected ? detected : level),
+                         __ATOMIC_RELAXED);
+}
+
+const char *rs_simd_level_name(rs_simd_level level) {
+        switch (level) {
+        case RS_SIMD_SSE2:
+                return "sse2";
+        case RS_SIMD_AVX2:
+                return "avx2";
+        case RS_SIMD_AVX512:
+                return "avx512";
+        default:
+                return "scalar";
+        }
+}
+
+typedef struct rs_simd_kernels {
+        rs_simd_block_fn block;
+        rs_simd_binary_fn binary[4];
+        rs_simd_axpy_fn axpy;
+        rs_simd_dot_fn dot;
+} rs_simd_kernels;
+
+#define RS_SIMD_KERNELS(isa)                                                   \
+        {rs_simd_block_##isa,                                                  \
+         {rs_simd_add_##isa, rs_simd_sub_##isa, rs_simd_mul_##isa,             \
+          rs_simd_div_##isa},                                                  \
+         rs_simd_axpy_##isa,                                                   \
+         rs_simd_dot_##isa}
+
+static const rs_simd_kernels rs_simd_table[] = {
+        [RS_SIMD_SCALAR] = RS_SIMD_KERNELS(scalar),
+#ifdef RS_SIMD_X86
+        [RS_SIMD_SSE2] = RS_SIMD_KERNELS(sse2),
+        [RS_SIMD_AVX2] = RS_SIMD_KERNELS(avx2),
+        [RS_SIMD_AVX512] = RS_SIMD_KERNELS(avx512),
+#endif
+};
+
+/* the level is clamped to what the cpu supports, so on other platforms it
+   never leaves RS_SIMD_SCALAR */
+static const rs_simd_kernels *rs_simd_kernels_get(void) {
+        return &rs_simd_table[rs_simd_get_level()];
+}
+
+void rs_simd_block_stats(const double *data, size_t length, rs_stats *out) {
+        if (length == 0) {
+                rs_stats_reset(out);
+                return;
+        }
+        rs_simd_kernels_get()->block(data, length, out);
+}
+
+void rs_simd_stats(const double *data, size_t length, rs_stats *out) {
+        rs_simd_block_fn block = rs_simd_kernels_get()->block;
+        rs_stats b;
+
+        rs_stats_reset(out);
+        for (size_t i = 0; i < length; i += RS_SIMD_BLOCK) {
+                size_t n = length - i < RS_SIMD_BLOCK ? length - i
+                                                      : RS_SIMD_BLOCK;
+                block(data + i, n, &b);
+                rs_stats_combine(out, &b);
+        }
+}
+
+void rs_simd_binary(rs_simd_op op, double *left, const double *right,
+                    size_t length, rs_stats *out) {
+        const rs_simd_kernels *k = rs_simd_kernels_get();
+        rs_stats b;
+
+        if (!out) {
+                k->binary[op](left, right, length);
+                return;
+        }
+        rs_stats_reset(out);
+        for (size_t i = 0; i < length; i += RS_SIMD_BLOCK) {
+                size_t n = length - i < RS_SIMD_BLOCK ? length - i
+                                                      : RS_SIMD_BLOCK;
+                k->binary[op](left + i, right + i, n);
+                k->block(left + i, n, &b);
+                rs_stats_combine(out, &b);
+        }
+}
+
+void rs_simd_axpy(double *left, double k, const double *right, size_t length,
+                  rs_stats *out) {
+        const rs_simd_kernels *kern = rs_simd_kernels_get();
+        rs_stats b;
+
+        if (!out) {
+                kern->axpy(left, k, right, length);
+                return;
+        }
+        rs_stats_reset(out);
+        for (size_t i = 0; i < length; i += RS_SIMD_BLOCK) {
+                size_t n = length - i < RS_SIMD_BLOCK ? length - i
+                                                      : RS_SIMD_BLOCK;
+                kern->axpy(left + i, k, right + i, n);
+                kern->block(left + i, n, &b);
+                rs_stats_combine(out, &b);
+        }
+}
+
+double rs_simd_dot(const double *left, const double *right, size_t length,
+                   double *left_norm, double *right_norm) {
+        double sums[3];
+
+        rs_simd_kernels_get()->dot(left, right, length, sums);
+        if (left_norm)
+                *left_norm = sqrt(sums[1]);
+        if (right_norm)
+                *right_norm = sqrt(sums[2]);
+        return sums[0];
+}
@@ -0,0 +1,52 @@
+#ifndef __RS_SIMD_H_
+#define __RS_SIMD_H_
+
+#include <stddef.h>
+#include "rs_moments.h"
+
+/*
+vectorised batch kernels. the widest instruction set supported by the cpu is
+detected once at runtime, rs_simd_set_level can force a narrower one (or the
+scalar fallback) for testing and benchmarking.
+*/
+
+typedef enum rs_simd_level {
+        RS_SIMD_SCALAR = 0,
+        RS_SIMD_SSE2,
+        RS_SIMD_AVX2,
+        RS_SIMD_AVX512
+} rs_simd_level;
+
+/* doubles per block, sized so a block stays in L1 between its two passes */
+#define RS_SIMD_BLOCK 2048
+
+rs_simd_level rs_simd_detect(void);
+rs_simd_level rs_simd_get_level(void);
+void rs_simd_set_level(rs_simd_level level);
+const char *rs_simd_level_name(rs_simd_level level);
+
+/* summary of a block of at most RS_SIMD_BLOCK values */
+void rs_simd_block_stats(const double *data, size_t length, rs_stats *out);
+/* summary of an array of any length */
+void rs_simd_stats(const double *data, size_t length, rs_stats *out);
+
+typedef enum rs_simd_op {
+        RS_SIMD_ADD = 0,
+        RS_SIMD_SUB,
+        RS_SIMD_MUL,
+        RS_SIMD_DIV
+} rs_simd_op;
+
+/* left = left op right, and when out is not NULL the summary of the result
+   gathered in the same pass */
+void rs_simd_binary(rs_simd_op op, double *left, const double *right,
+                    size_t length, rs_stats *out);
+/* left += k * right, out as for rs_simd_binary */
+void rs_simd_axpy(double *left, double k, const double *right, size_t length,
+                  rs_stats *out);
+/* returns left.right, optionally the euclidean norms of both in the same
+   sweep */
+double rs_simd_dot(const double *left, const double *right, size_t length,
+                   double *left_norm, double *right_norm);
+
+#endif
@@ -0,0 +1,217 @@
+#include "rs_skiplist.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* node 0 is the head, node 1 the sentinel every level ends on. walks stop
+   at it by index, not by its +inf value, so +inf items sort before it */
+#define RS_SKIPLIST_HEAD 0
+#define RS_SKIPLIST_NIL 1
+
+#define RS_SKIPLIST_NEXT(s, node, level)                                       \
+        ((s)->links[(node) * (s)->levels + (level)].next)
+#define RS_SKIPLIST_WIDTH(s, node, level)                                      \
+        ((s)->links[(node) * (s)->levels + (level)].width)
+
+rs_skiplist *rs_skiplist_alloc(size_t capacity) {
+        if (capacity < 1) {
+                fprintf(stderr, "[rs_skiplist_alloc] capacity must be > 0\n");
+                return NULL;
+        }
+        rs_skiplist *s = malloc(sizeof(rs_skiplist));
+        if (!s) {
+                fprintf(stderr, "[rs_skiplist_alloc] malloc error\n");
+                return NULL;
+        }
+        size_t nodes = capacity + 2;
+
+        /* enough levels that the top one holds O(1) nodes */
+        s->levels = 1;
+        while (((size_t)1 << s->levels) < capacity && s->levels < 32)
+                s->levels++;
+        s->capacity = capacity;
+        s->values = malloc(nodes * sizeof(double));
+        s->node_levels = malloc(nodes * sizeof(uint8_t));
+        s->links = malloc(nodes * s->levels * sizeof(rs_skiplist_link));
+        if (!s->values || !s->node_levels || !s->links) {
+                fprintf(stderr, "[rs_skiplist_alloc] malloc error\n");
+                rs_skiplist_free(s);
+                return NULL;
+        }
+        rs_skiplist_reset(s);
+        return s;
+}
+
+void rs_skiplist_free(rs_skiplist *s) {
+        if (s) {
+                free(s->values);
+                free(s->node_levels);
+                free(s->links);
+                free(s);
+                s = NULL;
+        }
+}
+
+void rs_skiplist_reset(rs_skiplist *s) {
+        s->count = 0;
+        s->rng = 0x9e3779b97f4a7c15ull;
+        s->values[RS_SKIPLIST_HEAD] = -INFINITY;
+        s->values[RS_SKIPLIST_NIL] = INFINITY;
+        for (size_t level = 0; level < s->levels; level++) {
+                RS_SKIPLIST_NEXT(s, RS_SKIPLIST_HEAD, level) = RS_SKIPLIST_NIL;
+                RS_SKIPLIST_WIDTH(s, RS_SKIPLIST_HEAD, level) = 1;
+                RS_SKIPLIST_NEXT(s, RS_SKIPLIST_NIL, level) = RS_SKIPLIST_NIL;
+                RS_SKIPLIST_WIDTH(s, RS_SKIPLIST_NIL, level) = 0;
+        }
+        /* free nodes are chained through their level 0 link */
+        s->free_list = 2;
+        for (size_t node = 2; node < s->capacity + 2; node++)
+                RS_SKIPLIST_NEXT(s, node, 0) =
+                    node + 1 < s->capacity + 2 ? node + 1 : RS_SKIPLIST_NIL;
+}
+
+/* geometric with p = 1/2, from the trailing zeros of an xorshift draw */
+static size_t rs_skiplist_random_level(rs_skiplist *s) {
+        uint64_t x = s->rng;
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        s->rng = x;
+        size_t level = 1 + (size_t)__builtin_ctzll(x | (1ull << 63));
+        return level < s->levels ? level : s->levels;
+}
+
+/* by bits, since -ffinite-math-only folds isnan and x != x to false */
+static bool rs_skiplist_is_nan(double x) {
+        uint64_t bits;
+
+        memcpy(&bits, &x, sizeof(bits));
+        return (bits & 0x7fffffffffffffffu) > 0x7ff0000000000000u;
+}
+
+int rs_skiplist_insert(rs_skiplist *s, double value) {
+        if (rs_skiplist_is_nan(value)) {
+                fprintf(stderr, "[rs_skiplist_insert] NaN has no rank\n");
+                return -1;
+        }
+        if (s->count == s->capacity) {
+                fprintf(stderr, "[rs_skiplist_insert] skiplist is full\n");
+                return -1;
+        }
+        size_t chain[64];
+        size_t steps_at_level[64];
+        size_t node = RS_SKIPLIST_HEAD;
+
+        for (size_t level = s->levels; level-- > 0;) {
+                steps_at_level[level] = 0;
+                for (;;) {
+                        size_t next = RS_SKIPLIST_NEXT(s, node, level);
+                        if (next == RS_SKIPLIST_NIL ||
+                            !(s->values[next] <= value))
+                                break;
+                        steps_at_level[level] +=
+                            RS_SKIPLIST_WIDTH(s, node, level);
+                        node = next;
+                }
+                chain[level] = node;
+        }
+
+        size_t fresh = s->free_list;
+        size_t d = rs_skiplist_random_level(s);
+        size_t steps = 0;
+
+        s->free_list = RS_SKIPLIST_NEXT(s, fresh, 0);
+        s->values[fresh] = value;
+        s->node_levels[fresh] = (uint8_t)d;
+        for (size_t level = 0; level < d; level++) {
+                size_t prev = chain[level];
+                RS_SKIPLIST_NEXT(s, fresh, level) =
+                    RS_SKIPLIST_NEXT(s, prev, level);
+                RS_SKIPLIST_NEXT(s, prev, level) = fresh;
+                RS_SKIPLIST_WIDTH(s, fresh, level) =
+                    RS_SKIPLIST_WIDTH(s, prev, level) - steps;
+                RS_SKIPLIST_WIDTH(s, prev, level) = steps + 1;
+                steps += steps_at_level[level];
+        }
+        for (size_t level = d; level < s->levels; level++)
+                RS_SKIPLIST_WIDTH(s, chain[level], level)++;
+        s->count++;
+        return 0;
+}
+
+int rs_skiplist_remove(rs_skiplist *s, double value) {
+        size_t chain[64];
+        size_t node = RS_SKIPLIST_HEAD;
+
+        for (size_t level = s->levels; level-- > 0;) {
+                for (;;) {
+                        size_t next = RS_SKIPLIST_NEXT(s, node, level);
+                        if (next == RS_SKIPLIST_NIL ||
+                            !(s->values[next] < value))
+                                break;
+                        node = next;
+                }
+                chain[level] = node;
+        }
+        size_t victim = RS_SKIPLIST_NEXT(s, chain[0], 0);
+        if (victim == RS_SKIPLIST_NIL || s->values[victim] != value) {
+                fprintf(stderr, "[rs_skiplist_remove] value not found\n");
+                return -1;
+        }
+        size_t d = s->node_levels[victim];
+
+        for (size_t level = 0; level < d; level++) {
+                size_t prev = chain[level];
+                RS_SKIPLIST_WIDTH(s, prev, level) +=
+                    RS_SKIPLIST_WIDTH(s, victim, level) - 1;
+                RS_SKIPLIST_NEXT(s, prev, level) =
+                    RS_SKIPLIST_NEXT(s, victim, level);
+        }
+        for (size_t level = d; level < s->levels; level++)
+                RS_SKIPLIST_WIDTH(s, chain[level], level)--;
+        RS_SKIPLIST_NEXT(s, victim, 0) = s->free_list;
+        s->free_list = victim;
+        s->count--;
+        return 0;
+}
+
+/* rank < count, past it the walk reaches NIL, whose width of 0 never
+   moves it on */
+static size_t rs_skiplist_find(rs_skiplist *s, size_t rank) {
+        size_t node = RS_SKIPLIST_HEAD;
+        size_t i = rank + 1;
+
+        for (size_t level = s->levels; level-- > 0;) {
+                while (RS_SKIPLIST_WIDTH(s, node, level) <= i) {
+                        i -= RS_SKIPLIST_WIDTH(s, node, level);
+                        node = RS_SKIPLIST_NEXT(s, node, level);
+                }
+        }
+        return node;
+}
+
+double rs_skiplist_get(rs_skiplist *s, size_t rank) {
+        if (rank >= s->count)
+                return NAN;
+        return s->values[rs_skiplist_find(s, rank)];
+}
+
+double rs_skiplist_quantile(rs_skiplist *s, double q) {
+        if (s->count == 0 || !(q >= 0.0 && q <= 1.0))
+                return NAN;
+        double position = q * (double)(s->count - 1);
+        size_t lo = (size_t)position;
+        double frac = position - (double)lo;
+        size_t node = rs_skiplist_find(s, lo);
+        double value = s->values[node];
+
+        /* rank lo + 1 is the level 0 successor. equal neighbours are not
+           interpolated, so a run of +inf or -inf stays infinite */
+        if (frac > 0.0 && lo + 1 < s->count) {
+                double next = s->values[RS_SKIPLIST_NEXT(s, node, 0)];
+                if (next != value)
+                        value += (next - value) * frac;
+        }
+        return value;
+}
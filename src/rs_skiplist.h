@@ -0,0 +1,45 @@
+#ifndef __RS_SKIPLIST_H_
+#define __RS_SKIPLIST_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+indexable skiplist holding the sorted contents of a sliding window, after
+R. Hettinger's recipe (ActiveState 576930) as used by pandas' rolling median.
+each link also stores how many items it skips, so insert, remove and
+lookup by rank are O(log n) expected. nodes come from a pool sized at
+alloc, nothing is allocated per step. NaN has no rank, insert rejects it.
+*/
+
+/* a forward link and how many ranks it advances, kept together */
+typedef struct rs_skiplist_link {
+        size_t next;
+        size_t width;
+} rs_skiplist_link;
+
+typedef struct rs_skiplist {
+        size_t capacity;
+        size_t count;
+        size_t levels;
+        size_t free_list;
+        uint64_t rng;
+        double *values;
+        uint8_t *node_levels;
+        rs_skiplist_link *links;
+} rs_skiplist;
+
+rs_skiplist *rs_skiplist_alloc(size_t capacity);
+void rs_skiplist_free(rs_skiplist *s);
+void rs_skiplist_reset(rs_skiplist *s);
+int rs_skiplist_insert(rs_skiplist *s, double value);
+/* removes one item equal to value */
+int rs_skiplist_remove(rs_skiplist *s, double value);
+/* rank-th smallest item, NAN for rank >= count */
+double rs_skiplist_get(rs_skiplist *s, size_t rank);
+/* quantile q in [0, 1] with linear interpolation between ranks, NAN for
+   an empty list or q outside [0, 1] */
+double rs_skiplist_quantile(rs_skiplist *s, double q);
+
+#endif
@@ -0,0 +1,195 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "rs_spsc.h"
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+
+rs_spsc *rs_spsc_alloc(size_t capacity) {
+        size_t size = 1;
+
+        while (size < capacity)
+                size <<= 1;
+        rs_spsc *q = rs_allocator_aligned.alloc(NULL, sizeof(rs_spsc));
+        if (!q) {
+                fprintf(stderr, "[rs_spsc_alloc] malloc error\n");
+                return NULL;
+        }
+        memset(q, 0, sizeof(rs_spsc));
+        q->capacity = size;
+        q->mask = size - 1;
+        q->data = rs_allocator_aligned.alloc(NULL, size * sizeof(double));
+        if (!q->data) {
+                fprintf(stderr, "[rs_spsc_alloc] malloc error\n");
+                rs_allocator_aligned.release(NULL, q, sizeof(rs_spsc));
+                return NULL;
+        }
+        return q;
+}
+
+void rs_spsc_free(rs_spsc *q) {
+        if (q) {
+                rs_allocator_aligned.release(NULL, q->data,
+                                             q->capacity * sizeof(double));
+                rs_allocator_aligned.release(NULL, q, sizeof(rs_spsc));
+        }
+}
+
+/* copies n items in or out of the ring from index on, wrapping once */
+static void rs_spsc_copy_in(rs_spsc *q, size_t index, const double *items,
+                            size_t n) {
+        size_t offset = index & q->mask;
+        size_t first = q->capacity - offset < n ? q->capacity - offset : n;
+
+        memcpy(q->data + offset, items, first * sizeof(double));
+        memcpy(q->data, items + first, (n - first) * sizeof(double));
+}
+
+static void rs_spsc_copy_out(rs_spsc *q, size_t index, double *out,
+                             size_t n) {
+        size_t offset = index & q->mask;
+        size_t first = q->capacity - offset < n ? q->capacity - offset : n;
+
+        memcpy(out, q->data + offset, first * sizeof(double));
+        memcpy(out + first, q->data, (n - first) * sizeof(double));
+}
+
+size_t rs_spsc_publish(rs_spsc *q, const double *items, size_t n) {
+        size_t head = q->head;
+        size_t free_slots = q->capacity - (head - q->tail_cache);
+
+        if (free_slots < n) {
+                q->tail_cache = __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE);
+                free_slots = q->capacity - (head - q->tail_cache);
+        }
+        if (n > free_slots)
+                n = free_slots;
+        if (n > 0) {
+                rs_spsc_copy_in(q, head, items, n);
+                __atomic_store_n(&q->head, head + n, __ATOMIC_RELEASE);
+        }
+        return n;
+}
+
+size_t rs_spsc_consume(rs_spsc *q, double *out, size_t n) {
+        size_t tail = q->tail;
+        size_t available = q->head_cache - tail;
+
+        if (available < n) {
+                q->head_cache = __atomic_load_n(&q->head, __ATOMIC_ACQUIRE);
+                available = q->head_cache - tail;
+        }
+        if (n > available)
+                n = available;
+        if (n > 0) {
+                rs_spsc_copy_out(q, tail, out, n);
+                __atomic_store_n(&q->tail, tail + n, __ATOMIC_RELEASE);
+        }
+        return n;
+}
+
+size_t rs_spsc_size(rs_spsc *q) {
+        size_t head = __atomic_load_n(&q->head, __ATOMIC_ACQUIRE);
+        size_t tail = __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE);
+        return head - tail;
+}
+
+static void rs_spsc_worker_apply(rs_spsc_worker *w, size_t n) {
+        if (w->vector) {
+                for (size_t i = 0; i < n; i++)
+                        rs_vector_item_push(w->vector, w->batch[i]);
+        } else {
+                rs_rolling_stream_push_batch(w->stream, w->batch, n);
+        }
+        w->n_consumed += n;
+}
+
+/* unless wait is set this is skipped when a reader holds the lock, the
+   next batch will refresh it */
+static void rs_spsc_worker_publish(rs_spsc_worker *w, bool wait) {
+        if (wait)
+                pthread_mutex_lock(&w->lock);
+        else if (pthread_mutex_trylock(&w->lock) != 0)
+                return;
+        w->snapshot.n_consumed = w->n_consumed;
+        if (w->vector)
+                rs_vector_get_stats(w->vector, &w->snapshot.stats);
+        else
+                rs_rolling_stream_current(w->stream, &w->snapshot.row);
+        pthread_mutex_unlock(&w->lock);
+}
+
+static void *rs_spsc_worker_main(void *arg) {
+        rs_spsc_worker *w = arg;
+
+        for (;;) {
+                /* read stop first: anything published before it was set is
+                   then visible to the consume below */
+                int stop = __atomic_load_n(&w->stop, __ATOMIC_ACQUIRE);
+                size_t n = rs_spsc_consume(w->queue, w->batch, w->batch_size);
+                if (n > 0) {
+                        rs_spsc_worker_apply(w, n);
+                        rs_spsc_worker_publish(w, false);
+                } else if (stop) {
+                        break;
+                } else {
+                        sched_yield();
+                }
+        }
+        /* the final state is always published */
+        rs_spsc_worker_publish(w, true);
+        return NULL;
+}
+
+rs_spsc_worker *rs_spsc_worker_start(rs_spsc *q, rs_vector *vector,
+                                     rs_rolling_stream *stream,
+                                     size_t batch_size) {
+        if (!vector == !stream) {
+                fprintf(stderr, "[rs_spsc_worker_start] need exactly one of "
+                                "vector and stream\n");
+                return NULL;
+        }
+        rs_spsc_worker *w = calloc(1, sizeof(rs_spsc_worker));
+        if (!w) {
+                fprintf(stderr, "[rs_spsc_worker_start] malloc error\n");
+                return NULL;
+        }
+        w->queue = q;
+        w->vector = vector;
+        w->stream = stream;
+        w->batch_size = batch_size > 0 ? batch_size : 1024;
+        w->batch = malloc(w->batch_size * sizeof(double));
+        if (!w->batch) {
+                fprintf(stderr, "[rs_spsc_worker_start] malloc error\n");
+                free(w);
+                return NULL;
+        }
+        pthread_mutex_init(&w->lock, NULL);
+        rs_spsc_worker_publish(w, true);
+        if (pthread_create(&w->thread, NULL, rs_spsc_worker_main, w) != 0) {
+                fprintf(stderr, "[rs_spsc_worker_start] pthread_create "
+                                "error\n");
+                pthread_mutex_destroy(&w->lock);
+                free(w->batch);
+                free(w);
+                return NULL;
+        }
+        return w;
+}
+
+void rs_spsc_worker_stop(rs_spsc_worker *w) {
+        if (w) {
+                __atomic_store_n(&w->stop, 1, __ATOMIC_RELEASE);
+                pthread_join(w->thread, NULL);
+                pthread_mutex_destroy(&w->lock);
+                free(w->batch);
+                free(w);
+                w = NULL;
+        }
+}
+
+void rs_spsc_worker_snapshot(rs_spsc_worker *w, rs_spsc_snapshot *out) {
+        pthread_mutex_lock(&w->lock);
+        *out = w->snapshot;
+        pthread_mutex_unlock(&w->lock);
+}
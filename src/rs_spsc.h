@@ -0,0 +1,74 @@
+#ifndef __RS_SPSC_H_
+#define __RS_SPSC_H_
+
+#include <pthread.h>
+#include "rs_rolling_stream.h"
+
+#define RS_CACHE_LINE 64
+
+/*
+lock-free single-producer/single-consumer ring of doubles. head is only
+written by the producer and tail only by the consumer, each on its own cache
+line and published with release stores / read with acquire loads. both
+sides keep a private copy of the other's index and only reload it when the
+ring looks full (producer) or empty (consumer), so the shared lines bounce
+once per batch rather than once per item. capacity is a power of two.
+*/
+
+typedef struct rs_spsc {
+        double *data;
+        size_t capacity;
+        size_t mask;
+        /* producer line */
+        __attribute__((aligned(RS_CACHE_LINE))) size_t head;
+        size_t tail_cache;
+        /* consumer line */
+        __attribute__((aligned(RS_CACHE_LINE))) size_t tail;
+        size_t head_cache;
+} __attribute__((aligned(RS_CACHE_LINE))) rs_spsc;
+
+rs_spsc *rs_spsc_alloc(size_t capacity);
+void rs_spsc_free(rs_spsc *q);
+/* producer: publishes up to n items, returns how many fitted */
+size_t rs_spsc_publish(rs_spsc *q, const double *items, size_t n);
+/* consumer: takes up to n items, returns how many there were */
+size_t rs_spsc_consume(rs_spsc *q, double *out, size_t n);
+/* items waiting, exact only from the producer or consumer thread */
+size_t rs_spsc_size(rs_spsc *q);
+
+/*
+a thread draining a ring into an rs_vector or an rs_rolling_stream. after
+each drained batch the worker refreshes a snapshot of the accumulator if it
+can take the snapshot lock without waiting, so readers never hold up the
+worker and nothing ever holds up the producer.
+*/
+
+typedef struct rs_spsc_snapshot {
+        size_t n_consumed;
+        rs_stats stats;
+        rs_rolling_row row;
+} rs_spsc_snapshot;
+
+typedef struct rs_spsc_worker {
+        rs_spsc *queue;
+        rs_vector *vector;
+        rs_rolling_stream *stream;
+        double *batch;
+        size_t batch_size;
+        size_t n_consumed;
+        int stop;
+        pthread_t thread;
+        pthread_mutex_t lock;
+        rs_spsc_snapshot snapshot;
+} rs_spsc_worker;
+
+/* exactly one of vector and stream is set, batch_size 0 means 1024 */
+rs_spsc_worker *rs_spsc_worker_start(rs_spsc *q, rs_vector *vector,
+                                     rs_rolling_stream *stream,
+                                     size_t batch_size);
+/* call once the producer is done: drains what is left in the ring, joins
+   and frees the worker */
+void rs_spsc_worker_stop(rs_spsc_worker *w);
+void rs_spsc_worker_snapshot(rs_spsc_worker *w, rs_spsc_snapshot *out);
+
+#endif
@@ -1,28 +1,176 @@
 #include "rs_vector.h"
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 #include "circular_array.h"
+#include "rs_instr.h"
 #include "rs_rolling.h"
+#include "rs_simd.h"
+
+/*
+seqlock latch after Linux's seqcount_latch. bumping seq to odd redirects
+readers to slots[1] while slots[0] is rewritten, bumping it to even sends
+them back to slots[0] while slots[1] catches up, so a reader only retries
+when a whole half-update lands during its copy and never spins on a writer
+mid-update. the words are accessed with relaxed atomics and ordered by the
+fences around seq, as in Boehm's "Can seqlocks get along with programming
+language memory models?" (MSPC 2012).
+*/
+#define RS_VECTOR_LATCH_WORDS (sizeof(rs_stats) / sizeof(uint64_t))
+
+typedef struct rs_vector_latch {
+        size_t seq;
+        __attribute__((aligned(RS_ALLOC_ALIGNMENT)))
+        uint64_t slots[2][RS_VECTOR_LATCH_WORDS];
+} rs_vector_latch;
+
+static void rs_vector_latch_write(uint64_t *slot, const uint64_t *words) {
+        for (size_t k = 0; k < RS_VECTOR_LATCH_WORDS; k++)
+                __atomic_store_n(&slot[k], words[k], __ATOMIC_RELAXED);
+}
+
+static void rs_vector_publish(rs_vector *v) {
+        rs_vector_latch *l = v->latch;
+        size_t seq = __atomic_load_n(&l->seq, __ATOMIC_RELAXED);
+        uint64_t words[RS_VECTOR_LATCH_WORDS];
+        rs_stats s;
+
+        rs_vector_get_stats(v, &s);
+        memcpy(words, &s, sizeof(s));
+        __atomic_store_n(&l->seq, seq + 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        rs_vector_latch_write(l->slots[0], words);
+        __atomic_store_n(&l->seq, seq + 2, __ATOMIC_RELEASE);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        rs_vector_latch_write(l->slots[1], words);
+}
+
+int rs_vector_set_concurrent(rs_vector *v, bool enabled) {
+        if (!enabled) {
+                if (v->latch) {
+                        rs_allocator_aligned.release(NULL, v->latch,
+                                                     sizeof(rs_vector_latch));
+                        v->latch = NULL;
+                }
+                return 0;
+        }
+        if (!v->latch) {
+                v->latch =
+                    rs_allocator_aligned.alloc(NULL, sizeof(rs_vector_latch));
+                if (!v->latch) {
+                        fprintf(stderr,
+                                "[rs_vector_set_concurrent] malloc error\n");
+                        return -1;
+                }
+                v->latch->seq = 0;
+                rs_vector_publish(v);
+        }
+        return 0;
+}
+
+int rs_vector_snapshot(rs_vector *v, rs_stats *out) {
+        rs_vector_latch *l = v->latch;
+        uint64_t words[RS_VECTOR_LATCH_WORDS];
+        size_t seq;
+
+        if (!l) {
+                fprintf(stderr, "[rs_vector_snapshot] vector is not "
+                                "concurrent\n");
+                return -1;
+        }
+        do {
+                seq = __atomic_load_n(&l->seq, __ATOMIC_ACQUIRE);
+                const uint64_t *slot = l->slots[seq & 1];
+                for (size_t k = 0; k < RS_VECTOR_LATCH_WORDS; k++)
+                        words[k] = __atomic_load_n(&slot[k], __ATOMIC_RELAXED);
+                __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        } while (__atomic_load_n(&l->seq, __ATOMIC_RELAXED) != seq);
+        memcpy(out, words, sizeof(*out));
+        return 0;
+}
+
+const rs_vector_policy rs_vector_policy_default = {
+        .growth = CAPACITY_INCREASE_FACTOR,
+        .shrink = CAPACITY_INCREASE_FACTOR * CAPACITY_INCREASE_FACTOR,
+        .zero = true,
+        .allocator = &rs_allocator_default};
 
 rs_vector *rs_vector_alloc(size_t init_capacity) {
+        return rs_vector_alloc_policy(init_capacity, &rs_vector_policy_default);
+}
+
+rs_vector *rs_vector_alloc_policy(size_t init_capacity,
+                                  const rs_vector_policy *policy) {
+        if (!(policy->growth > 1.0) ||
+            (policy->shrink != 0.0 && !(policy->shrink > policy->growth))) {
+                fprintf(stderr, "[rs_vector_alloc_policy] growth must be > 1 "
+                                "and shrink 0 or > growth\n");
+                return NULL;
+        }
         if (init_capacity == 0) {
                 init_capacity = 1;
         }
         rs_vector *v = malloc(sizeof(rs_vector));
         if (!v) {
-                fprintf(stderr, "[rs_vector_alloc] malloc error\n");
+                fprintf(stderr, "[rs_vector_alloc_policy] malloc error\n");
                 return NULL;
         }
+        const rs_allocator *a = policy->allocator;
+        v->policy = *policy;
+        v->latch = NULL;
+        v->sketch = NULL;
+        v->prefix = NULL;
+        v->prefix_capacity = 0;
+        if (policy->stats_only) {
+                v->capacity = 0;
+                v->data = NULL;
+                rs_vector_reset(v);
+                return v;
+        }
         v->capacity = init_capacity + 1;
-        v->data = malloc(sizeof(double) * v->capacity);
+        v->data = a->alloc(a->ctx, sizeof(double) * v->capacity);
+        if (!v->data) {
+                fprintf(stderr, "[rs_vector_alloc_policy] malloc error\n");
+                free(v);
+                return NULL;
+        }
+        rs_vector_reset(v);
+        return v;
+}
+
+rs_vector *rs_vector_place(rs_arena *a, size_t init_capacity) {
+        rs_vector *v = rs_arena_take(a, sizeof(rs_vector));
+        double *data = rs_arena_take(a, sizeof(double) * (init_capacity + 1));
+
+        if (!v || !data) {
+                return NULL;
+        }
+        v->policy = rs_vector_policy_default;
+        v->policy.shrink = 0.0;
+        v->latch = NULL;
+        v->sketch = NULL;
+        v->prefix = NULL;
+        v->prefix_capacity = 0;
+        v->policy.allocator = &rs_allocator_fixed;
+        v->capacity = init_capacity + 1;
+        v->data = data;
         rs_vector_reset(v);
         return v;
 }
 
 void rs_vector_free(rs_vector *v) {
         if (v) {
+                rs_vector_set_concurrent(v, false);
+                rs_kll_free(v->sketch);
+                if (v->prefix) {
+                        const rs_allocator *a = v->policy.allocator;
+                        a->release(a->ctx, v->prefix,
+                                   2 * v->prefix_capacity * sizeof(double));
+                }
                 if (v->data) {
-                        free(v->data);
+                        const rs_allocator *a = v->policy.allocator;
+                        a->release(a->ctx, v->data,
+                                   v->capacity * sizeof(double));
                         v->data = NULL;
                 }
                 free(v);
@@ -32,7 +180,11 @@ void rs_vector_free(rs_vector *v) {
 
 void rs_vector_reset(rs_vector *v) {
         // zero everything out
-        memset(v->data, 0, v->capacity * sizeof(double));
+        if (v->policy.zero && v->data)
+                memset(v->data, 0, v->capacity * sizeof(double));
+        if (v->sketch)
+                rs_kll_reset(v->sketch);
+        v->prefix_count = 0;
         v->count = 0;
         v->mean = 0.0;
         v->M2 = 0.0;
@@ -41,53 +193,101 @@ void rs_vector_reset(rs_vector *v) {
         v->sum = 0.0;
         v->min = 0.0;
         v->max = 0.0;
+        if (v->latch)
+                rs_vector_publish(v);
 }
 
+/* bytes_moved counts what the allocator may copy, the smaller of the two
+   sizes, whether or not it manages to grow in place */
 int rs_vector_resize(rs_vector *v, size_t new_size) {
-        static size_t call_ctr = 0;
-        call_ctr++;
+        const rs_allocator *a = v->policy.allocator;
 
-        v->capacity = new_size;
-        double *data = realloc(v->data, v->capacity * sizeof(double));
+        if (!rs_vector_check_data("rs_vector_resize", v))
+                return -1;
+        RS_INSTR_TIME_BEGIN(t0);
+        double *data = a->resize(a->ctx, v->data, v->capacity * sizeof(double),
+                                 new_size * sizeof(double));
+        RS_INSTR_TIME_END(t0, resize_ticks);
         if (data) {
+                RS_INSTR_ADD(resizes, 1);
+                RS_INSTR_ADD(resize_bytes,
+                             (new_size < v->capacity ? new_size : v->capacity) *
+                                 sizeof(double));
                 v->data = data;
+                v->capacity = new_size;
                 return 0;
         }
         return -1;
 }
 
-int rs_vector_item_push(rs_vector *v, double item) {
-        static size_t func_call = 0;
+/* room for n_items without reallocating, never shrinks */
+int rs_vector_reserve(rs_vector *v, size_t n_items) {
+        if (!rs_vector_check_data("rs_vector_reserve", v))
+                return -1;
+        if (v->capacity < n_items + 1) {
+                return rs_vector_resize(v, n_items + 1);
+        }
+        return 0;
+}
 
-        if (v->count == v->capacity - 1) {
-                func_call++;
-                rs_vector_expand(v);
+bool rs_vector_check_data(const char *fn, rs_vector *v) {
+        if (v->policy.stats_only) {
+                fprintf(stderr, "[%s] stats-only vector stores no data\n", fn);
+                return false;
+        }
+        return true;
+}
+
+int rs_vector_item_push(rs_vector *v, double item) {
+        RS_INSTR_ADD(pushes, 1);
+        if (!v->policy.stats_only) {
+                if (v->count == v->capacity - 1) {
+                        if (rs_vector_expand(v) != 0) {
+                                fprintf(stderr, "[rs_vector_item_push] "
+                                                "realloc error\n");
+                                return -1;
+                        }
+                }
+                v->data[v->count] = item;
         }
-        v->data[v->count] = item;
         rs_vector_update(v, item);
+        if (v->sketch)
+                return rs_kll_update(v->sketch, item);
         return 0;
 }
 
 double rs_vector_item_pop(rs_vector *v) {
-        double item = v->data[v->count];
-        v->data[v->count] = 0.0;
+        if (!rs_vector_check_data("rs_vector_item_pop", v))
+                return 0.0;
+        if (v->count == 0) {
+                fprintf(stderr, "[rs_vector_item_pop] empty vector\n");
+                return 0.0;
+        }
+        double item = v->data[v->count - 1];
+        if (v->policy.zero)
+                v->data[v->count - 1] = 0.0;
         // v->count--; will be (de)incremented in update
         rs_vector_update_remove(v, item);
-        if (v->count == (v->capacity / CAPACITY_INCREASE_FACTOR) - 1) {
+        if (v->policy.shrink > 0.0 &&
+            (double)(v->count + 1) * v->policy.shrink <= (double)v->capacity) {
                 rs_vector_contract(v);
         }
         return item;
 }
 
 int rs_vector_expand(rs_vector *v) {
-        size_t new_size = v->capacity * CAPACITY_INCREASE_FACTOR;
+        size_t new_size = (size_t)ceil(v->capacity * v->policy.growth);
         int rc = rs_vector_resize(v, new_size);
 
         return rc;
 }
 
 int rs_vector_contract(rs_vector *v) {
-        size_t new_size = v->capacity / CAPACITY_INCREASE_FACTOR;
+        size_t new_size = (size_t)(v->capacity / v->policy.growth);
+        if (new_size < v->count + 1)
+                new_size = v->count + 1;
+        if (new_size < 2)
+                new_size = 2;
         int rc = rs_vector_resize(v, new_size);
         return rc;
 }
@@ -105,6 +305,8 @@ void rs_vector_print_stats(rs_vector *v) {
 }
 
 void rs_vector_print(rs_vector *v) {
+        if (!rs_vector_check_data("rs_vector_print", v))
+                return;
         fprintf(stdout, "rs_vector [%.2f, ", rs_vector_get(v, 0));
         for (size_t i = 1; i < v->count - 1; i++) {
                 fprintf(stdout, "%.2f, ", rs_vector_get(v, i));
@@ -137,16 +339,94 @@ void rs_vector_update(rs_vector *v, double item) {
                  6.0 * delta_nsq * v->M2 - 4.0 * delta_n * v->M3;
         v->M3 += term1 * delta_n * (n - 2.0) - 3.0 * delta_n * v->M2;
         v->M2 += term1;
+        if (v->latch)
+                rs_vector_publish(v);
+}
+
+static void rs_vector_store_stats(rs_vector *v, const rs_stats *s) {
+        v->count = s->count;
+        v->min = s->min;
+        v->max = s->max;
+        v->sum = s->sum;
+        v->mean = s->mean;
+        v->M2 = s->M2;
+        v->M3 = s->M3;
+        v->M4 = s->M4;
+        if (v->latch)
+                rs_vector_publish(v);
+}
+
+/* extends the prefix extrema over data[prefix_count, count), growing the
+   block to the data capacity so later pushes rarely regrow it. every item
+   is scanned once per validation, so it costs O(1) amortised per push */
+static int rs_vector_extend_prefix(rs_vector *v) {
+        const rs_allocator *a = v->policy.allocator;
+
+        if (v->prefix_capacity < v->count) {
+                size_t capacity = v->capacity > v->count ? v->capacity
+                                                         : v->count;
+                size_t size = 2 * capacity * sizeof(double);
+                double *prefix =
+                    v->prefix ? a->resize(a->ctx, v->prefix,
+                                          2 * v->prefix_capacity *
+                                              sizeof(double),
+                                          size)
+                              : a->alloc(a->ctx, size);
+                if (!prefix)
+                        return -1;
+                v->prefix = prefix;
+                v->prefix_capacity = capacity;
+        }
+        for (size_t i = v->prefix_count; i < v->count; i++) {
+                double item = v->data[i];
+                double min = item, max = item;
+                if (i > 0) {
+                        double prev_min = v->prefix[2 * i - 2];
+                        double prev_max = v->prefix[2 * i - 1];
+                        if (prev_min < min) min = prev_min;
+                        if (prev_max > max) max = prev_max;
+                }
+                v->prefix[2 * i] = min;
+                v->prefix[2 * i + 1] = max;
+        }
+        v->prefix_count = v->count;
+        return 0;
 }
 
-/* need to use n+1 after decrement in term1, M3/M4 */
-/* TODO algo to update min/max                     */
+/* only a removed extremum can change min/max, they are then read from the
+   prefix extrema of the items left, O(1) once the prefix is valid. a
+   stats-only vector keeps no items, and a fixed allocator cannot hold the
+   prefix, so there min/max become NAN until reset or calculate */
+static void rs_vector_remove_extrema(rs_vector *v, double item) {
+        if (item > v->min && item < v->max)
+                return;
+        if (v->policy.stats_only || rs_vector_extend_prefix(v) != 0) {
+                v->min = NAN;
+                v->max = NAN;
+                return;
+        }
+        v->min = v->prefix[2 * v->count - 2];
+        v->max = v->prefix[2 * v->count - 1];
+}
+
+/* need to use n+1 after decrement in term1, M3/M4. item must be the last
+   stored item, data[count - 1], as rs_vector_item_pop removes it */
 void rs_vector_update_remove(rs_vector *v, double item) {
         v->sum -= item;
         double delta, delta_n, delta_nsq, term1;
 
         double n1 = (double)v->count;
         double n = (double)--v->count;
+        /* data[count] is gone, the prefix up to it stays valid */
+        if (v->prefix_count > v->count)
+                v->prefix_count = v->count;
+        if (v->count == 0) {
+                rs_stats empty;
+                rs_stats_reset(&empty);
+                rs_vector_store_stats(v, &empty);
+                return;
+        }
+        rs_vector_remove_extrema(v, item);
         delta = item - v->mean;
         delta_n = delta / n;
         delta_nsq = delta_n * delta_n;
@@ -156,79 +436,229 @@ void rs_vector_update_remove(rs_vector *v, double item) {
         v->M3 -= term1 * delta_n * (n1 - 2.0) - 3.0 * delta_n * v->M2;
         v->M4 -= term1 * delta_nsq * (n1 * n1 - 3.0 * n1 + 3.0) +
                  6.0 * delta_nsq * v->M2 - 4.0 * delta_n * v->M3;
+        if (v->latch)
+                rs_vector_publish(v);
 }
 
-void rs_vector_add(rs_vector *left, rs_vector *right) {
-        for (size_t i = 0; i < left->count; i++) {
-                double ai = rs_vector_get(left, i);
-                double bi = rs_vector_get(right, i);
-                left->data[i] = ai + bi;
-        }
+void rs_vector_get_stats(rs_vector *v, rs_stats *out) {
+        out->count = v->count;
+        out->min = v->min;
+        out->max = v->max;
+        out->sum = v->sum;
+        out->mean = v->mean;
+        out->M2 = v->M2;
+        out->M3 = v->M3;
+        out->M4 = v->M4;
 }
 
-void rs_vector_sub(rs_vector *left, rs_vector *right) {
-        for (size_t i = 0; i < left->count; i++) {
-                double ai = rs_vector_get(left, i);
-                double bi = rs_vector_get(right, i);
-                left->data[i] = ai - bi;
+/* refeeds the sketch from data[0, count) after data or count changed under
+   it. a stats-only vector has nothing to refeed from, its sketch is dropped
+   instead. a failed update also drops it rather than leave it partial */
+static void rs_vector_rebuild_sketch(rs_vector *v) {
+        if (!v->sketch)
+                return;
+        if (!v->policy.stats_only) {
+                int rc = 0;
+                rs_kll_reset(v->sketch);
+                for (size_t i = 0; rc == 0 && i < v->count; i++)
+                        rc = rs_kll_update(v->sketch, v->data[i]);
+                if (rc == 0)
+                        return;
         }
+        fprintf(stderr, "[rs_vector_set_stats] sketch cannot be rebuilt, "
+                        "dropped\n");
+        rs_kll_free(v->sketch);
+        v->sketch = NULL;
 }
-void rs_vector_mul(rs_vector *left, rs_vector *right) {
-        for (size_t i = 0; i < left->count; i++) {
-                double ai = rs_vector_get(left, i);
-                double bi = rs_vector_get(right, i);
-                left->data[i] = ai * bi;
+
+/* count is taken from the summary, data is not touched. the sketch is
+   rebuilt from data, see rs_vector_set_sketch, and the prefix extrema are
+   recomputed on the next pop that needs them */
+void rs_vector_set_stats(rs_vector *v, const rs_stats *s) {
+        rs_vector_store_stats(v, s);
+        v->prefix_count = 0;
+        rs_vector_rebuild_sketch(v);
+}
+
+/* (re)computes the running stats from the stored data in one vectorised
+   batch, see rs_simd.c */
+void rs_vector_calculate(rs_vector *v) {
+        rs_stats s;
+
+        if (!rs_vector_check_data("rs_vector_calculate", v))
+                return;
+        rs_simd_stats(v->data, v->count, &s);
+        rs_vector_set_stats(v, &s);
+}
+
+rs_vector *rs_vector_alloc_calculate(double *data, size_t length) {
+        rs_vector *v = rs_vector_alloc(length);
+        if (!v) {
+                fprintf(stderr, "[rs_vector_alloc_calculate] malloc error\n");
+                return NULL;
         }
+        memcpy(v->data, data, length * sizeof(double));
+        v->count = length;
+        rs_vector_calculate(v);
+        return v;
 }
-void rs_vector_div(rs_vector *left, rs_vector *right) {
-        for (size_t i = 0; i < left->count; i++) {
-                double ai = rs_vector_get(left, i);
-                double bi = rs_vector_get(right, i);
-                left->data[i] = ai / bi;
+
+int rs_vector_set_sketch(rs_vector *v, size_t k) {
+        rs_kll_free(v->sketch);
+        v->sketch = NULL;
+        if (k == 0)
+                return 0;
+        v->sketch = rs_kll_alloc(k);
+        if (!v->sketch)
+                return -1;
+        for (size_t i = 0; !v->policy.stats_only && i < v->count; i++) {
+                if (rs_kll_update(v->sketch, v->data[i]) != 0)
+                        return -1;
         }
+        return 0;
 }
-double rs_vector_dot(rs_vector *left, rs_vector *right) {
-        double sum = 0.0;
 
-        for (size_t i = 0; i < left->count; i++) {
-                double ai = rs_vector_get(left, i);
-                double bi = rs_vector_get(right, i);
-                sum += ai * bi;
+int rs_vector_quantiles(rs_vector *v, const double *q, size_t n, double *out) {
+        if (!v->sketch) {
+                fprintf(stderr, "[rs_vector_quantiles] vector has no "
+                                "sketch\n");
+                return -1;
         }
-        return sum;
+        return rs_kll_quantiles(v->sketch, q, n, out);
 }
 
-int main(int argc, char *argv[]) {
-        if (argc > 1) {
-                size_t n_vars = strtoul(argv[1], NULL, 0);
-                // size_t window = strtoul(argv[2], NULL, 0);
+double rs_vector_quantile(rs_vector *v, double q) {
+        double out;
 
-                rs_vector *a = rs_vector_alloc(1);
-                rs_vector *b = rs_vector_alloc(1);
+        if (rs_vector_quantiles(v, &q, 1, &out) != 0)
+                return NAN;
+        return out;
+}
+
+/* appends src to dst, combining the running stats exactly in O(1) rather
+   than replaying every item through rs_vector_update. a stats-only dst only
+   takes the stats and sketch, which is how shards are summarised */
+int rs_vector_merge(rs_vector *dst, rs_vector *src) {
+        rs_stats a, b;
 
-                for (size_t i = 0; i < n_vars; i++) {
-                        rs_vector_item_push(a, (double)i + 1);
-                        rs_vector_item_push(b, (double)n_vars - i);
+        if (dst == src) {
+                fprintf(stderr, "[rs_vector_merge] cannot merge into itself\n");
+                return -1;
+        }
+        if ((!dst->policy.stats_only || (dst->sketch && !src->sketch)) &&
+            !rs_vector_check_data("rs_vector_merge", src))
+                return -1;
+        /* everything that can fail runs before dst's data and stats change */
+        if (!dst->policy.stats_only &&
+            rs_vector_reserve(dst, dst->count + src->count) != 0) {
+                fprintf(stderr, "[rs_vector_merge] realloc error\n");
+                return -1;
+        }
+        if (dst->sketch) {
+                int rc = 0;
+                if (src->sketch)
+                        rc = rs_kll_merge(dst->sketch, src->sketch);
+                for (size_t i = 0; rc == 0 && !src->sketch && i < src->count;
+                     i++)
+                        rc = rs_kll_update(dst->sketch, src->data[i]);
+                /* last fallible step, but a failure can leave the sketch
+                   partly merged, so it is dropped rather than kept */
+                if (rc != 0) {
+                        fprintf(stderr, "[rs_vector_merge] sketch merge "
+                                        "failed, dropped\n");
+                        rs_kll_free(dst->sketch);
+                        dst->sketch = NULL;
+                        return -1;
                 }
-                rs_vector_print(a);
-                rs_vector_print(b);
-                rs_vector_add(a, b);
-                rs_vector_print(a);
-                rs_vector_sub(a, b);
-                rs_vector_print(a);
-                rs_vector_mul(a, b);
-                rs_vector_print(a);
-                rs_vector_div(a, b);
-                rs_vector_print(a);
-                double d = rs_vector_dot(a, b);
-                fprintf(stdout, "Dot product: %.2f\n", d);
-                // rs_vector_print(v);
-                /*rs_rolling *r = rs_rolling_alloc(v, window);
-                rs_rolling_roll(r, 0);
-                rs_rolling_print(r);
-
-                rs_rolling_free(r);*/
-                rs_vector_free(a);
-                rs_vector_free(b);
-        }
-}
\ No newline at end of file
+        }
+        if (!dst->policy.stats_only)
+                memcpy(dst->data + dst->count, src->data,
+                       src->count * sizeof(double));
+        rs_vector_get_stats(dst, &a);
+        rs_vector_get_stats(src, &b);
+        rs_stats_combine(&a, &b);
+        rs_vector_store_stats(dst, &a);
+        return 0;
+}
+
+static bool rs_vector_check_lengths(const char *fn, rs_vector *left,
+                                    rs_vector *right) {
+        if (!rs_vector_check_data(fn, left) || !rs_vector_check_data(fn, right))
+                return false;
+        if (right->count < left->count) {
+                fprintf(stderr, "[%s] right length %zu < left length %zu\n",
+                        fn, right->count, left->count);
+                return false;
+        }
+        return true;
+}
+
+/* element-wise ops write into left and refresh its running stats in the
+   same blocked pass, see rs_simd.c */
+static void rs_vector_binary(const char *fn, rs_simd_op op, rs_vector *left,
+                             rs_vector *right) {
+        rs_stats s;
+
+        if (rs_vector_check_lengths(fn, left, right)) {
+                RS_INSTR_TIME_BEGIN(t0);
+                rs_simd_binary(op, left->data, right->data, left->count, &s);
+                rs_vector_set_stats(left, &s);
+                RS_INSTR_TIME_END(t0, elementwise_ticks);
+                RS_INSTR_ADD(elementwise_ops, 1);
+                RS_INSTR_ADD(elementwise_items, left->count);
+        }
+}
+
+void rs_vector_add(rs_vector *left, rs_vector *right) {
+        rs_vector_binary("rs_vector_add", RS_SIMD_ADD, left, right);
+}
+
+void rs_vector_sub(rs_vector *left, rs_vector *right) {
+        rs_vector_binary("rs_vector_sub", RS_SIMD_SUB, left, right);
+}
+
+void rs_vector_mul(rs_vector *left, rs_vector *right) {
+        rs_vector_binary("rs_vector_mul", RS_SIMD_MUL, left, right);
+}
+
+void rs_vector_div(rs_vector *left, rs_vector *right) {
+        rs_vector_binary("rs_vector_div", RS_SIMD_DIV, left, right);
+}
+
+/* left += k * right */
+void rs_vector_axpy(rs_vector *left, double k, rs_vector *right) {
+        rs_stats s;
+
+        if (rs_vector_check_lengths("rs_vector_axpy", left, right)) {
+                RS_INSTR_TIME_BEGIN(t0);
+                rs_simd_axpy(left->data, k, right->data, left->count, &s);
+                rs_vector_set_stats(left, &s);
+                RS_INSTR_TIME_END(t0, elementwise_ticks);
+                RS_INSTR_ADD(elementwise_ops, 1);
+                RS_INSTR_ADD(elementwise_items, left->count);
+        }
+}
+
+double rs_vector_dot(rs_vector *left, rs_vector *right) {
+        return rs_vector_dot_norms(left, right, NULL, NULL);
+}
+
+/* dot product plus the euclidean norms of both vectors in one sweep,
+   either norm pointer may be NULL. all three are 0 on a length error */
+double rs_vector_dot_norms(rs_vector *left, rs_vector *right,
+                           double *left_norm, double *right_norm) {
+        if (!rs_vector_check_lengths("rs_vector_dot", left, right)) {
+                if (left_norm)
+                        *left_norm = 0.0;
+                if (right_norm)
+                        *right_norm = 0.0;
+                return 0.0;
+        }
+        RS_INSTR_TIME_BEGIN(t0);
+        double dot = rs_simd_dot(left->data, right->data, left->count,
+                                 left_norm, right_norm);
+        RS_INSTR_TIME_END(t0, elementwise_ticks);
+        RS_INSTR_ADD(elementwise_ops, 1);
+        RS_INSTR_ADD(elementwise_items, left->count);
+        return dot;
+}
@@ -2,12 +2,38 @@
 #define __RS_VECTOR_H_
 
 #include "circular_array.h"
+#include "rs_alloc.h"
+#include "rs_kll.h"
+#include "rs_moments.h"
 #include <math.h>
 #include <stdbool.h>
 #include <stdlib.h>
 
 #define CAPACITY_INCREASE_FACTOR 2
 
+/*
+storage policy of a vector. capacity is multiplied by growth when full and
+divided by it once count drops below capacity / shrink. shrink must be
+strictly above growth, leaving a band where push/pop never reallocate (at
+shrink == growth a push/pop at the boundary would reallocate every time);
+shrink 0 never contracts. zero clears storage on alloc, reset and pop. stats_only never
+stores data: pushes only feed the running stats (and the sketch, see
+rs_vector_set_sketch), so memory stays O(1) however many items arrive, and
+anything that reads data back (get, pop, calculate, element-wise ops,
+printing, writing, rolling and expression sources) or sizes the buffer
+(resize, reserve) fails instead, see rs_vector_check_data.
+*/
+typedef struct rs_vector_policy {
+        double growth;
+        double shrink;
+        bool zero;
+        bool stats_only;
+        const rs_allocator *allocator;
+} rs_vector_policy;
+
+/* growth 2, shrink 4, zeroed, malloc */
+extern const rs_vector_policy rs_vector_policy_default;
+
 typedef struct rs_vector {
         bool calc;
         size_t last_calc_index;
@@ -21,27 +47,80 @@ typedef struct rs_vector {
         size_t count;
         size_t capacity;
         double *data;
+        rs_vector_policy policy;
+        struct rs_vector_latch *latch;
+        rs_kll *sketch;
+        /* min, max of data[0, i] at 2i, 2i + 1 for i < prefix_count, built
+           on the first pop of an extremum, see rs_vector_update_remove */
+        double *prefix;
+        size_t prefix_capacity;
+        size_t prefix_count;
 } rs_vector;
 
 rs_vector *rs_vector_alloc(size_t init_capacity);
+rs_vector *rs_vector_alloc_policy(size_t init_capacity,
+                                  const rs_vector_policy *policy);
+/* fixed capacity, carved from an arena, not to be passed to rs_vector_free */
+rs_vector *rs_vector_place(rs_arena *a, size_t init_capacity);
 rs_vector *rs_vector_alloc_calculate(double *data, size_t length);
 void rs_vector_free(rs_vector *v);
 void rs_vector_reset(rs_vector *v);
+/* both refuse a stats-only vector, which keeps no buffer */
 int rs_vector_resize(rs_vector *v, size_t new_size);
+int rs_vector_reserve(rs_vector *v, size_t n_items);
+/* false, with a message naming fn, when v keeps no data to read back */
+bool rs_vector_check_data(const char *fn, rs_vector *v);
 int rs_vector_expand(rs_vector *v);
 int rs_vector_contract(rs_vector *v);
 int rs_vector_item_push(rs_vector *v, double item);
 double rs_vector_item_pop(rs_vector *v);
 void rs_vector_update(rs_vector *v, double item);
+/* item must be data[count - 1], as after a pop. min/max stay O(1): when
+   item was one of them they are read from running prefix extrema kept next
+   to data, and are NAN on a stats-only or fixed-allocator vector */
 void rs_vector_update_remove(rs_vector *v, double item);
 
 void rs_vector_add(rs_vector *left, rs_vector *right);
 void rs_vector_sub(rs_vector *left, rs_vector *right);
 void rs_vector_mul(rs_vector *left, rs_vector *right);
 void rs_vector_div(rs_vector *left, rs_vector *right);
+void rs_vector_axpy(rs_vector *left, double k, rs_vector *right);
 double rs_vector_dot(rs_vector *left, rs_vector *right);
+double rs_vector_dot_norms(rs_vector *left, rs_vector *right,
+                           double *left_norm, double *right_norm);
+
+/*
+concurrent-read mode: every change to the running stats is also published
+to a seqlock latch (two copies of the stats, the writer only ever updating
+the one readers are not directed to), so any number of readers can take
+consistent snapshots while a single writer pushes and the writer never
+waits for them. enable before starting readers, disable after they stop.
+*/
+int rs_vector_set_concurrent(rs_vector *v, bool enabled);
+/* safe from any thread, -1 if the vector is not concurrent */
+int rs_vector_snapshot(rs_vector *v, rs_stats *out);
+
+/*
+quantile sketch fed by every rs_vector_item_push, k as in rs_kll.h (0
+drops it). stored items are fed in when it is attached. rs_vector_merge
+merges the sketches, pop leaves the sketch as it is. anything that rewrites
+data or the stats (element-wise ops, axpy, calculate, set_stats, expression
+evaluation into v) rebuilds the sketch from the stored data; a stats-only
+vector cannot be rebuilt, so there it is dropped and the quantiles are NAN
+/ -1 until rs_vector_set_sketch is called again.
+*/
+int rs_vector_set_sketch(rs_vector *v, size_t k);
+/* approximate quantiles from the sketch, NAN / -1 without one */
+double rs_vector_quantile(rs_vector *v, double q);
+int rs_vector_quantiles(rs_vector *v, const double *q, size_t n, double *out);
 
 void rs_vector_calculate(rs_vector *v);
+void rs_vector_get_stats(rs_vector *v, rs_stats *out);
+void rs_vector_set_stats(rs_vector *v, const rs_stats *s);
+/* appends src to dst (dst != src), on -1 dst's data and stats are
+   unchanged; a sketch that fails part way through merging is dropped, see
+   rs_vector_set_sketch */
+int rs_vector_merge(rs_vector *dst, rs_vector *src);
 
 rs_vector *rs_vector_copy(rs_vector *src);
 
@@ -69,6 +148,8 @@ void rs_vector_print_stats(rs_vector *v);
 void rs_vector_print(rs_vector *v);
 
 static inline double rs_vector_get(rs_vector *v, size_t index) {
+        if (!rs_vector_check_data("rs_vector_get", v))
+                return 0.0;
         if (index > v->count - 1) {
                 fprintf(stderr, "[rs_vector_get] index %zu out of range %zu\n",
                         index, v->count);